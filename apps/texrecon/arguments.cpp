@@ -17,6 +17,25 @@
 #define WRITE_TIMINGS "write_timings"
 #define SKIP_HOLE_FILLING "skip_hole_filling"
 #define KEEP_UNSEEN_FACES "keep_unseen_faces"
+#define VIEW_CACHE_DIR "view_cache_dir"
+#define VIEW_MANIFEST "view_manifest"
+#define WARM_START_LABELING "warm_start_labeling"
+#define MRF_SOLVER "mrf_solver"
+#define MRF_MAX_ITERATIONS "mrf_max_iterations"
+#define MRF_MAX_TIME "mrf_max_time"
+#define MRF_TOLERANCE "mrf_tolerance"
+#define MRF_MAX_LABELS "mrf_max_labels"
+#define MULTILEVEL_VIEW_SELECTION "multilevel_view_selection"
+#define FAST_VIEW_SELECTION "fast_view_selection"
+#define MIN_ISLAND_SIZE "min_island_size"
+#define MIN_ISLAND_AREA "min_island_area"
+#define WRITE_MRF_ENERGIES "write_mrf_energies"
+
+#ifdef RESEARCH
+#define DEFAULT_MRF_SOLVER mrf::GCO
+#else
+#define DEFAULT_MRF_SOLVER mrf::LBP
+#endif
 
 Arguments parse_args(int argc, char **argv) {
     util::Arguments args;
@@ -26,7 +45,7 @@ Arguments parse_args(int argc, char **argv) {
     args.set_helptext_indent(34);
     args.set_description("Textures a mesh given images in form of a 3D scene.");
     args.set_usage("Usage: " + std::string(argv[0]) + " [options] IN_SCENE IN_MESH OUT_PREFIX"
-        "\n\nIN_SCENE := (SCENE_FOLDER | BUNDLE_FILE | MVE_SCENE::EMBEDDING)"
+        "\n\nIN_SCENE := (SCENE_FOLDER | BUNDLE_FILE | MVE_SCENE::EMBEDDING | SHARED_SCENE)"
         "\n\nSCENE_FOLDER:"
         "\nWithin a scene folder a .cam file has to be given for each image."
         "\nA .cam file is structured as follows:"
@@ -44,6 +63,9 @@ Arguments parse_args(int argc, char **argv) {
         "\nSince the bundle file contains relative paths to the images please make sure you did not move them (relative to the bundle) or rename them after the bundling process."
         "\n\nMVE_SCENE::EMBEDDING:"
         "\nThis is the scene representation we use in our research group: http://www.gris.tu-darmstadt.de/projects/multiview-environment/."
+        "\n\nSHARED_SCENE:"
+        "\nA POSIX shared memory object (shm:NAME) or an inherited file descriptor (fd:N) prepared by an upstream process, containing cameras and mesh (see libs/tex/shared_scene.h)."
+        " The same descriptor can be given as IN_MESH."
         "\n\nIN_MESH:"
         "\nThe mesh that you want to texture and which needs to be in the same coordinate frame as the camera parameters. You can reconstruct one, e.g. with CMVS: http://www.di.ens.fr/cmvs/"
         "\n\nOUT_PREFIX:"
@@ -54,6 +76,9 @@ Arguments parse_args(int argc, char **argv) {
         "Skip calculation of data costs and use the ones provided in the given file");
     args.add_option('L',"labeling_file", true,
         "Skip view selection and use the labeling provided in the given file");
+    args.add_option('\0', WARM_START_LABELING, true,
+        "Initialize the view selection with the labeling provided in the given file "
+        "(e.g. of a previous run) instead of the lowest data costs");
     args.add_option('d',"data_term", true,
         "Data term: {" +
         choices<tex::DataTerm>() + "} [" + choice_string<tex::DataTerm>(tex::GMI) + "]");
@@ -63,6 +88,32 @@ Arguments parse_args(int argc, char **argv) {
     args.add_option('o',"outlier_removal", true,
         "Photometric outlier (pedestrians etc.) removal method: {" +
         choices<tex::OutlierRemoval>() +  "} [" + choice_string<tex::OutlierRemoval>(tex::NONE) + "]");
+    args.add_option('\0', MRF_SOLVER, true,
+        "Solver for the view selection MRF: {" +
+        choices<mrf::SOLVER_TYPE>() + "} [" + choice_string<mrf::SOLVER_TYPE>(DEFAULT_MRF_SOLVER) + "]");
+    args.add_option('\0', MRF_MAX_ITERATIONS, true,
+        "Maximum number of iterations per MRF, 0 for no limit [0]");
+    args.add_option('\0', MRF_MAX_TIME, true,
+        "Maximum runtime in seconds per MRF, 0 for no limit [0]");
+    args.add_option('\0', MRF_TOLERANCE, true,
+        "Stop the optimization of a MRF once an iteration decreases its energy "
+        "by less than this fraction [0]");
+    args.add_option('\0', MRF_MAX_LABELS, true,
+        "Maximum number of candidate views per face (lowest data costs plus the "
+        "best views of adjacent faces), 0 for no limit [0]");
+    args.add_option('\0', MULTILEVEL_VIEW_SELECTION, false,
+        "Initialize the view selection with the solution for clusters of faces "
+        "and only refine it for a few iterations [false]");
+    args.add_option('\0', FAST_VIEW_SELECTION, false,
+        "Skip the MRF optimization: select the view with the lowest data cost for each face "
+        "and remove speckles by majority voting among neighboring faces (for previews) [false]");
+    args.add_option('\0', MIN_ISLAND_SIZE, true,
+        "Relabel connected faces with the same view which are fewer than this to an "
+        "adjacent view in which they are seen (reduces the number of texture patches), "
+        "0 to disable [0]");
+    args.add_option('\0', MIN_ISLAND_AREA, true,
+        "Relabel connected faces with the same view whose area (in squared mesh units) "
+        "is smaller than this as well, 0 to disable [0]");
     args.add_option('v',"view_selection_model", false,
         "Write out view selection model [false]");
     args.add_option('\0', SKIP_GEOMETRIC_VISIBILITY_TEST, false,
@@ -75,8 +126,16 @@ Arguments parse_args(int argc, char **argv) {
         "Skip hole filling [false]");
     args.add_option('\0', KEEP_UNSEEN_FACES, false,
         "Keep unseen faces [false]");
+    args.add_option('\0', VIEW_CACHE_DIR, true,
+        "Cache decoded images, validity masks and gradient magnitudes in the given directory "
+        "to reuse them in later runs on the same images");
+    args.add_option('\0', VIEW_MANIFEST, true,
+        "Load cameras and image dimensions from the given manifest file if it exists, "
+        "otherwise write them to it for faster startup of later runs");
     args.add_option('\0', WRITE_TIMINGS, false,
         "Write out timings for each algorithm step (OUT_PREFIX + _timings.csv)");
+    args.add_option('\0', WRITE_MRF_ENERGIES, false,
+        "Write out the energy of each MRF after each iteration (OUT_PREFIX + _mrf_energies.csv)");
     args.add_option('\0', NO_INTERMEDIATE_RESULTS, false,
         "Do not write out intermediate results");
     args.parse(argc, argv);
@@ -89,10 +148,22 @@ Arguments parse_args(int argc, char **argv) {
     /* Set defaults for optional arguments. */
     conf.data_cost_file = "";
     conf.labeling_file = "";
+    conf.view_cache_dir = "";
+    conf.view_manifest_file = "";
+    conf.warm_start_labeling_file = "";
 
     conf.settings.data_term = tex::GMI;
     conf.settings.smoothness_term = tex::POTTS;
     conf.settings.outlier_removal = tex::NONE;
+    conf.settings.solver_type = DEFAULT_MRF_SOLVER;
+    conf.settings.mrf_max_iterations = 0;
+    conf.settings.mrf_max_time = 0.0f;
+    conf.settings.mrf_tolerance = 0.0f;
+    conf.settings.mrf_max_labels = 0;
+    conf.settings.multilevel_view_selection = false;
+    conf.settings.fast_view_selection = false;
+    conf.settings.min_island_size = 0;
+    conf.settings.min_island_area = 0.0f;
     conf.settings.geometric_visibility_test = true;
     conf.settings.global_seam_leveling = true;
     conf.settings.local_seam_leveling = true;
@@ -100,6 +171,7 @@ Arguments parse_args(int argc, char **argv) {
     conf.settings.keep_unseen_faces = false;
 
     conf.write_timings = false;
+    conf.write_mrf_energies = false;
     conf.write_intermediate_results = true;
     conf.write_view_selection_model = false;
 
@@ -136,8 +208,34 @@ Arguments parse_args(int argc, char **argv) {
                 conf.settings.hole_filling = false;
             } else if (i->opt->lopt == KEEP_UNSEEN_FACES) {
                 conf.settings.keep_unseen_faces = true;
+            } else if (i->opt->lopt == MRF_SOLVER) {
+                conf.settings.solver_type = parse_choice<mrf::SOLVER_TYPE>(i->arg);
+            } else if (i->opt->lopt == MRF_MAX_ITERATIONS) {
+                conf.settings.mrf_max_iterations = i->get_arg<unsigned int>();
+            } else if (i->opt->lopt == MRF_MAX_TIME) {
+                conf.settings.mrf_max_time = i->get_arg<float>();
+            } else if (i->opt->lopt == MRF_TOLERANCE) {
+                conf.settings.mrf_tolerance = i->get_arg<float>();
+            } else if (i->opt->lopt == MRF_MAX_LABELS) {
+                conf.settings.mrf_max_labels = i->get_arg<unsigned int>();
+            } else if (i->opt->lopt == MULTILEVEL_VIEW_SELECTION) {
+                conf.settings.multilevel_view_selection = true;
+            } else if (i->opt->lopt == FAST_VIEW_SELECTION) {
+                conf.settings.fast_view_selection = true;
+            } else if (i->opt->lopt == MIN_ISLAND_SIZE) {
+                conf.settings.min_island_size = i->get_arg<unsigned int>();
+            } else if (i->opt->lopt == MIN_ISLAND_AREA) {
+                conf.settings.min_island_area = i->get_arg<float>();
+            } else if (i->opt->lopt == VIEW_CACHE_DIR) {
+                conf.view_cache_dir = i->arg;
+            } else if (i->opt->lopt == VIEW_MANIFEST) {
+                conf.view_manifest_file = i->arg;
+            } else if (i->opt->lopt == WARM_START_LABELING) {
+                conf.warm_start_labeling_file = i->arg;
             } else if (i->opt->lopt == WRITE_TIMINGS) {
                 conf.write_timings = true;
+            } else if (i->opt->lopt == WRITE_MRF_ENERGIES) {
+                conf.write_mrf_energies = true;
             } else if (i->opt->lopt == NO_INTERMEDIATE_RESULTS) {
                 conf.write_intermediate_results = false;
             } else {
@@ -165,9 +263,21 @@ Arguments::to_string(){
         << "Output prefix: \t" << out_prefix << std::endl
         << "Datacost file: \t" << data_cost_file << std::endl
         << "Labeling file: \t" << labeling_file << std::endl
+        << "Warm start labeling file: \t" << warm_start_labeling_file << std::endl
+        << "View cache directory: \t" << view_cache_dir << std::endl
+        << "View manifest: \t" << view_manifest_file << std::endl
         << "Data term: \t" << choice_string<tex::DataTerm>(settings.data_term) << std::endl
         << "Smoothness term: \t" << choice_string<tex::SmoothnessTerm>(settings.smoothness_term) << std::endl
         << "Outlier removal method: \t" << choice_string<tex::OutlierRemoval>(settings.outlier_removal) << std::endl
+        << "MRF solver: \t" << choice_string<mrf::SOLVER_TYPE>(settings.solver_type) << std::endl
+        << "MRF maximum iterations: \t" << settings.mrf_max_iterations << std::endl
+        << "MRF maximum time: \t" << settings.mrf_max_time << std::endl
+        << "MRF tolerance: \t" << settings.mrf_tolerance << std::endl
+        << "MRF maximum labels: \t" << settings.mrf_max_labels << std::endl
+        << "Multilevel view selection: \t" << bool_to_string(settings.multilevel_view_selection) << std::endl
+        << "Fast view selection: \t" << bool_to_string(settings.fast_view_selection) << std::endl
+        << "Minimum island size: \t" << settings.min_island_size << std::endl
+        << "Minimum island area: \t" << settings.min_island_area << std::endl
         << "Apply global seam leveling: \t" << bool_to_string(settings.global_seam_leveling) << std::endl
         << "Apply local seam leveling: \t" << bool_to_string(settings.local_seam_leveling) << std::endl;
 
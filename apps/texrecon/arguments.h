@@ -21,10 +21,14 @@ struct Arguments {
 
     std::string data_cost_file;
     std::string labeling_file;
+    std::string warm_start_labeling_file;
+    std::string view_cache_dir;
+    std::string view_manifest_file;
 
     tex::Settings settings;
 
     bool write_timings;
+    bool write_mrf_energies;
     bool write_intermediate_results;
     bool write_view_selection_model;
 
@@ -14,12 +14,12 @@
 #include <util/timer.h>
 #include <util/system.h>
 #include <util/file_system.h>
-#include <mve/mesh_io_ply.h>
 
 #include "tex/util.h"
 #include "tex/timer.h"
 #include "tex/debug.h"
 #include "tex/texturing.h"
+#include "tex/view_manifest.h"
 #include "tex/progress_counter.h"
 
 #include "arguments.h"
@@ -54,17 +54,51 @@ int main(int argc, char **argv) {
     std::cout << "Load and prepare mesh: " << std::endl;
     mve::TriangleMesh::Ptr mesh;
     try {
-        mesh = mve::geom::load_ply_mesh(conf.in_mesh);
+        mesh = tex::load_mesh(conf.in_mesh);
     } catch (std::exception& e) {
         std::cerr << "\tCould not load mesh: "<< e.what() << std::endl;
         std::exit(EXIT_FAILURE);
     }
-    mve::MeshInfo mesh_info(mesh);
+    /* The mesh info is initialized by prepare_mesh. */
+    mve::MeshInfo mesh_info;
     tex::prepare_mesh(&mesh_info, mesh);
 
     std::cout << "Generating texture views: " << std::endl;
     tex::TextureViews texture_views;
-    tex::generate_texture_views(conf.in_scene, &texture_views);
+    bool views_loaded = false;
+    if (!conf.view_manifest_file.empty()
+        && util::fs::file_exists(conf.view_manifest_file.c_str())) {
+        std::cout << "\tLoading view manifest... " << std::flush;
+        try {
+            tex::load_view_manifest(conf.view_manifest_file, conf.in_scene, &texture_views);
+            views_loaded = true;
+            std::cout << "done. (" << texture_views.size() << " views)" << std::endl;
+        } catch (util::FileException & e) {
+            std::cout << "failed!" << std::endl;
+            std::cerr << "\t" << e.what() << std::endl;
+        }
+    }
+
+    if (!views_loaded) {
+        tex::generate_texture_views(conf.in_scene, &texture_views);
+
+        if (!conf.view_manifest_file.empty()) {
+            try {
+                tex::save_view_manifest(conf.view_manifest_file, conf.in_scene, texture_views);
+            } catch (util::FileException & e) {
+                std::cerr << "\tCould not write view manifest: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    if (!conf.view_cache_dir.empty()) {
+        if (!util::fs::dir_exists(conf.view_cache_dir.c_str())
+            && !util::fs::mkdir(conf.view_cache_dir.c_str())) {
+            std::cerr << "Could not create view cache directory!" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        tex::setup_view_cache(conf.view_cache_dir, conf.settings, &texture_views);
+    }
 
     write_string_to_file(conf.out_prefix + ".conf", conf.to_string());
     timer.measure("Loading");
@@ -73,7 +107,7 @@ int main(int argc, char **argv) {
 
     std::cout << "Building adjacency graph: " << std::endl;
     tex::Graph graph(num_faces);
-    tex::build_adjacency_graph(mesh, mesh_info, &graph);
+    tex::build_adjacency_graph(mesh, &graph);
 
     if (conf.labeling_file.empty()) {
         std::cout << "View selection:" << std::endl;
@@ -101,8 +135,52 @@ int main(int argc, char **argv) {
         }
         timer.measure("Calculating data costs");
 
-        tex::view_selection(data_costs, &graph, conf.settings);
+        /* Labeling of a previous run to start the optimization from. */
+        std::vector<std::size_t> initial_labeling;
+        if (!conf.warm_start_labeling_file.empty()) {
+            std::cout << "\tLoading warm start labeling... " << std::flush;
+            try {
+                initial_labeling = vector_from_file<std::size_t>(conf.warm_start_labeling_file);
+            } catch (util::FileException e) {
+                std::cout << "failed!" << std::endl;
+                std::cerr << e.what() << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            std::cout << "done." << std::endl;
+
+            if (initial_labeling.size() != num_faces) {
+                std::cout << "\tWarm start labeling does not match the mesh - ignoring it." << std::endl;
+                initial_labeling.clear();
+            }
+            /* Views that do not exist anymore are treated as undefined. */
+            for (std::size_t & label : initial_labeling) {
+                if (label > texture_views.size()) label = 0;
+            }
+        }
+
+        /* Face areas for the minimal island area. */
+        std::vector<float> face_areas;
+        if (conf.settings.min_island_area > 0.0f) {
+            mve::TriangleMesh::FaceList const & faces = mesh->get_faces();
+            mve::TriangleMesh::VertexList const & vertices = mesh->get_vertices();
+            face_areas.resize(num_faces);
+            for (std::size_t i = 0; i < num_faces; ++i) {
+                math::Vec3f const & v1 = vertices[faces[3 * i]];
+                math::Vec3f const & v2 = vertices[faces[3 * i + 1]];
+                math::Vec3f const & v3 = vertices[faces[3 * i + 2]];
+                face_areas[i] = 0.5f * (v2 - v1).cross(v3 - v1).norm();
+            }
+        }
+
+        tex::MRFEnergyTrace trace;
+        tex::view_selection(data_costs, &graph, conf.settings,
+            conf.write_mrf_energies ? &trace : nullptr,
+            initial_labeling.empty() ? nullptr : &initial_labeling,
+            face_areas.empty() ? nullptr : &face_areas);
         timer.measure("Running MRF optimization");
+        if (conf.write_mrf_energies) {
+            tex::save_mrf_energies(conf.out_prefix + "_mrf_energies.csv", trace);
+        }
         std::cout << "\tTook: " << rwtimer.get_elapsed_sec() << "s" << std::endl;
 
         /* Write labeling to file. */
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "compressed_graph.h"
+#include "message.h"
+
+MRF_NAMESPACE_BEGIN
+
+CompressedGraph::CompressedGraph(int num_sites) :
+    finalized(false), labels_set(false), graph_set(false), vertex_labels(num_sites, 0),
+    vertex_data_costs(num_sites, MRF_MAX_ENERGYTERM),
+    energy_valid(false), current_energy(0.0) {}
+
+void CompressedGraph::build_layout(void) {
+    std::size_t const num_vertices = vertex_labels.size();
+
+    /* The compressed layout has already been given with set_graph. */
+    if (!graph_set) {
+        /* Scatter the staged data costs into the label arrays. */
+        label_offsets.assign(num_vertices + 1, 0);
+        for (StagedCost const & staged_cost : staged_costs)
+            label_offsets[staged_cost.site + 1] += 1;
+        for (std::size_t i = 0; i < num_vertices; ++i)
+            label_offsets[i + 1] += label_offsets[i];
+
+        labels.resize(staged_costs.size());
+        data_costs.resize(staged_costs.size());
+        std::vector<std::size_t> next(label_offsets.begin(), label_offsets.end() - 1);
+        for (StagedCost const & staged_cost : staged_costs) {
+            std::size_t idx = next[staged_cost.site]++;
+            labels[idx] = staged_cost.label;
+            data_costs[idx] = staged_cost.cost;
+        }
+        std::vector<StagedCost>().swap(staged_costs);
+
+        /* Incoming edges of each vertex. */
+        incoming_offsets.assign(num_vertices + 1, 0);
+        for (DirectedEdge const & edge : edges)
+            incoming_offsets[edge.v2 + 1] += 1;
+        for (std::size_t i = 0; i < num_vertices; ++i)
+            incoming_offsets[i + 1] += incoming_offsets[i];
+
+        incoming_edges.resize(edges.size());
+        next.assign(incoming_offsets.begin(), incoming_offsets.end() - 1);
+        for (std::size_t i = 0; i < edges.size(); ++i)
+            incoming_edges[next[edges[i].v2]++] = static_cast<int>(i);
+    }
+
+    /* Sort the labels of each vertex - required by the Potts message update
+     * and the label lookup. */
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, DATA_COST_TYPE> > vertex_costs;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for (std::size_t i = 0; i < num_vertices; ++i) {
+            std::size_t const begin = label_offsets[i];
+            std::size_t const end = label_offsets[i + 1];
+            if (std::is_sorted(labels.begin() + begin, labels.begin() + end)) continue;
+
+            vertex_costs.clear();
+            for (std::size_t j = begin; j < end; ++j)
+                vertex_costs.emplace_back(labels[j], data_costs[j]);
+            std::sort(vertex_costs.begin(), vertex_costs.end());
+            for (std::size_t j = begin; j < end; ++j) {
+                labels[j] = vertex_costs[j - begin].first;
+                data_costs[j] = vertex_costs[j - begin].second;
+            }
+        }
+    }
+
+    if (labels_set) init_labels();
+}
+
+/** Looks up the data costs of labels given with set_label. */
+void CompressedGraph::init_labels(void) {
+    #pragma omp parallel for
+    for (std::size_t v = 0; v < vertex_labels.size(); ++v) {
+        std::size_t const begin = label_offsets[v];
+        std::size_t const end = label_offsets[v + 1];
+        if (begin == end) continue;
+
+        auto it = std::lower_bound(labels.begin() + begin, labels.begin() + end, vertex_labels[v]);
+        if (it == labels.begin() + end || *it != vertex_labels[v]) {
+            it = labels.begin() + (std::min_element(data_costs.begin() + begin,
+                data_costs.begin() + end) - data_costs.begin());
+        }
+        vertex_labels[v] = *it;
+        vertex_data_costs[v] = data_costs[it - labels.begin()];
+    }
+}
+
+void CompressedGraph::init_message_offsets(std::vector<std::size_t> * msg_offsets) const {
+    msg_offsets->resize(edges.size() + 1);
+    (*msg_offsets)[0] = 0;
+    for (std::size_t i = 0; i < edges.size(); ++i)
+        (*msg_offsets)[i + 1] = (*msg_offsets)[i] + num_labels(edges[i].v2);
+}
+
+void CompressedGraph::init_certain_messages(std::vector<std::size_t> const & msg_offsets,
+    std::vector<ENERGY_TYPE> * msgs, bool both_directions) const {
+
+    bool const potts_model = smooth_cost_func == potts;
+    ENERGY_TYPE const certain = 0;
+    SmoothCostFunction const func = smooth_cost_func;
+    auto const smooth_cost = [func, both_directions] (int s1, int s2, int l1, int l2) {
+        return both_directions ? func(s1, s2, l1, l2) + func(s2, s1, l2, l1) : func(s1, s2, l1, l2);
+    };
+
+    #pragma omp parallel for
+    for (std::size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+        DirectedEdge const & edge = edges[edge_idx];
+        int const label1 = vertex_labels[edge.v1];
+        int const * labels2 = labels.data() + label_offsets[edge.v2];
+        std::size_t const num_labels2 = num_labels(edge.v2);
+        ENERGY_TYPE const weight = edge_weight(static_cast<int>(edge_idx));
+        ENERGY_TYPE * msg = msgs->data() + msg_offsets[edge_idx];
+        if (potts_model) {
+            potts_message(&label1, 1, &certain, labels2, num_labels2,
+                both_directions ? 2 * weight : weight, msg);
+        } else {
+            generic_message(edge.v1, edge.v2, smooth_cost,
+                &label1, 1, &certain, labels2, num_labels2, weight, msg);
+        }
+        normalize_message(msg, msg + num_labels2);
+    }
+}
+
+ENERGY_TYPE CompressedGraph::compute_energy() {
+    if (energy_valid) return static_cast<ENERGY_TYPE>(current_energy);
+    if (labels_set && !finalized) finalize();
+
+    double energy = smooth_cost_func == potts
+        ? smooth_energy(PottsSmoothCost())
+        : smooth_energy(FunctionSmoothCost(smooth_cost_func));
+
+    #pragma omp parallel for reduction(+:energy)
+    for (std::size_t vertex_idx = 0; vertex_idx < vertex_data_costs.size(); ++vertex_idx) {
+        energy += vertex_data_costs[vertex_idx];
+    }
+
+    current_energy = energy;
+    energy_valid = true;
+    return static_cast<ENERGY_TYPE>(current_energy);
+}
+
+void CompressedGraph::set_smooth_cost(SmoothCostFunction func) {
+    smooth_cost_func = func;
+    energy_valid = false;
+}
+
+void CompressedGraph::set_neighbors(int site1, int site2) {
+    assert(!finalized && !graph_set);
+    energy_valid = false;
+    edges.push_back(DirectedEdge(site1, site2));
+    edges.push_back(DirectedEdge(site2, site1));
+    if (!edge_weights.empty()) edge_weights.resize(edges.size(), ENERGY_TYPE(1));
+}
+
+void CompressedGraph::set_neighbors(int site1, int site2, ENERGY_TYPE weight) {
+    CompressedGraph::set_neighbors(site1, site2);
+    if (weight != ENERGY_TYPE(1) && edge_weights.empty())
+        edge_weights.assign(edges.size(), ENERGY_TYPE(1));
+    if (!edge_weights.empty()) {
+        edge_weights[edges.size() - 2] = weight;
+        edge_weights[edges.size() - 1] = weight;
+    }
+}
+
+void CompressedGraph::set_data_costs(int label, std::vector<SparseDataCost> const & costs) {
+    assert(!finalized && !graph_set);
+    energy_valid = false;
+    for (std::size_t i = 0; i < costs.size(); ++i) {
+        int site = costs[i].site;
+        DATA_COST_TYPE data_cost = costs[i].cost;
+        staged_costs.push_back({site, label, data_cost});
+
+        if (data_cost < vertex_data_costs[site]) {
+            vertex_labels[site] = label;
+            vertex_data_costs[site] = data_cost;
+        }
+    }
+}
+
+void CompressedGraph::set_graph(std::vector<std::size_t> const & neighbor_offsets,
+    std::vector<int> const & neighbors, std::vector<std::size_t> const & cost_offsets,
+    std::vector<int> const & site_labels, std::vector<DATA_COST_TYPE> const & costs,
+    std::vector<ENERGY_TYPE> const & weights) {
+
+    assert(!finalized && edges.empty() && staged_costs.empty());
+    std::size_t const num_vertices = vertex_labels.size();
+    assert(neighbor_offsets.size() == num_vertices + 1);
+    assert(cost_offsets.size() == num_vertices + 1);
+    assert(weights.empty() || weights.size() == neighbors.size());
+    energy_valid = false;
+
+    label_offsets = cost_offsets;
+    labels = site_labels;
+    data_costs.resize(costs.size());
+
+    /* Edges are created in pairs from the vertex with the lower index. */
+    std::vector<std::size_t> pair_offsets(num_vertices + 1, 0);
+    #pragma omp parallel for
+    for (std::size_t v = 0; v < num_vertices; ++v) {
+        for (std::size_t n = neighbor_offsets[v]; n < neighbor_offsets[v + 1]; ++n)
+            if (static_cast<std::size_t>(neighbors[n]) > v) pair_offsets[v + 1] += 1;
+    }
+    for (std::size_t v = 0; v < num_vertices; ++v)
+        pair_offsets[v + 1] += pair_offsets[v];
+    edges.assign(2 * pair_offsets.back(), DirectedEdge(0, 0));
+    edge_weights.assign(weights.empty() ? 0 : edges.size(), ENERGY_TYPE(1));
+
+    /* The incoming edges of a vertex are the reverse edges of its neighbors. */
+    incoming_offsets = neighbor_offsets;
+    incoming_edges.resize(neighbors.size());
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t v = 0; v < num_vertices; ++v) {
+        int const vertex = static_cast<int>(v);
+        std::size_t pair = pair_offsets[v];
+        for (std::size_t n = neighbor_offsets[v]; n < neighbor_offsets[v + 1]; ++n) {
+            int const neighbor = neighbors[n];
+            if (neighbor > vertex) {
+                edges[2 * pair] = DirectedEdge(vertex, neighbor);
+                edges[2 * pair + 1] = DirectedEdge(neighbor, vertex);
+                if (!weights.empty()) {
+                    edge_weights[2 * pair] = weights[n];
+                    edge_weights[2 * pair + 1] = weights[n];
+                }
+                incoming_edges[n] = static_cast<int>(2 * pair + 1);
+                pair += 1;
+                continue;
+            }
+
+            /* Pair of neighbor -> vertex: rank of vertex among the succeeding neighbors of neighbor. */
+            std::size_t neighbor_pair = pair_offsets[neighbor];
+            for (std::size_t m = neighbor_offsets[neighbor]; neighbors[m] != vertex; ++m)
+                if (neighbors[m] > neighbor) neighbor_pair += 1;
+            incoming_edges[n] = static_cast<int>(2 * neighbor_pair);
+        }
+
+        /* Initial labels with the lowest data costs (the lower label on ties, as with set_data_costs). */
+        for (std::size_t j = cost_offsets[v]; j < cost_offsets[v + 1]; ++j) {
+            data_costs[j] = costs[j];
+            if (data_costs[j] < vertex_data_costs[v] || (data_costs[j] == vertex_data_costs[v]
+                    && labels[j] < vertex_labels[v])) {
+                vertex_labels[v] = labels[j];
+                vertex_data_costs[v] = data_costs[j];
+            }
+        }
+    }
+
+    graph_set = true;
+}
+
+int CompressedGraph::what_label(int site) {
+    return vertex_labels[site];
+}
+
+void CompressedGraph::set_label(int site, int label) {
+    assert(!finalized);
+    vertex_labels[site] = label;
+    labels_set = true;
+    energy_valid = false;
+}
+
+int CompressedGraph::num_sites() {
+    return static_cast<int>(vertex_labels.size());
+}
+
+MRF_NAMESPACE_END
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef MRF_COMPRESSEDGRAPH_HEADER
+#define MRF_COMPRESSEDGRAPH_HEADER
+
+#include <cstddef>
+
+#include "graph.h"
+
+MRF_NAMESPACE_BEGIN
+
+/**
+  * Common base of the solvers which store the graph in a compressed (CSR)
+  * layout: the labels and data costs of all vertices are stored in contiguous
+  * arrays indexed by per vertex offsets (sorted by label), each edge is stored
+  * as a pair of directed edges and the incoming edges of each vertex are
+  * indexed by per vertex offsets as well.
+  *
+  * Neighbors and data costs are collected first and converted into the
+  * compressed layout by build_layout, which the solvers call on the first
+  * call of optimize. Neither neighbors nor data costs may be added after that.
+  * With set_graph the compressed layout is built directly from the given arrays.
+  */
+class CompressedGraph : public Graph {
+    protected:
+        struct DirectedEdge {
+            int v1;
+            int v2;
+            DirectedEdge(int v1, int v2) : v1(v1), v2(v2) {}
+        };
+
+        struct StagedCost {
+            int site;
+            int label;
+            DATA_COST_TYPE cost;
+        };
+
+        bool finalized;
+        /* Whether labels were given with set_label. */
+        bool labels_set;
+        /* Whether neighbors and data costs were given with set_graph. */
+        bool graph_set;
+        std::vector<StagedCost> staged_costs;
+
+        /* Current label and its data cost for each vertex. */
+        std::vector<int> vertex_labels;
+        std::vector<DATA_COST_TYPE> vertex_data_costs;
+
+        /* Energy of the current labeling, updated incrementally by the solvers. */
+        bool energy_valid;
+        double current_energy;
+
+        /* Labels and data costs of vertex v: [label_offsets[v], label_offsets[v + 1]). */
+        std::vector<std::size_t> label_offsets;
+        std::vector<int> labels;
+        std::vector<DATA_COST_TYPE> data_costs;
+
+        /* Incoming edges of vertex v: [incoming_offsets[v], incoming_offsets[v + 1]).
+         * Edges are stored in pairs, the reverse of edge e is e ^ 1. */
+        std::vector<std::size_t> incoming_offsets;
+        std::vector<int> incoming_edges;
+        std::vector<DirectedEdge> edges;
+        /* Weight of the smoothness term of each edge, empty if all weights are 1. */
+        std::vector<ENERGY_TYPE> edge_weights;
+
+        SmoothCostFunction smooth_cost_func;
+
+        /**
+          * Converts the collected neighbors and data costs into the compressed
+          * layout, sorts the labels of each vertex and looks up the data costs
+          * of labels given with set_label.
+          */
+        void build_layout(void);
+        /** Builds the layout and the solver specific state. */
+        virtual void finalize(void) = 0;
+
+        std::size_t num_labels(int vertex) const;
+        ENERGY_TYPE edge_weight(int edge_idx) const;
+
+        /** Offsets of the messages, one entry per label of the target vertex. */
+        void init_message_offsets(std::vector<std::size_t> * msg_offsets) const;
+        /**
+          * Sets the messages as if each vertex was certain about its label, based on
+          * the smoothness term of each edge in one or (both_directions) both directions.
+          */
+        void init_certain_messages(std::vector<std::size_t> const & msg_offsets,
+            std::vector<ENERGY_TYPE> * msgs, bool both_directions = false) const;
+
+        template <typename SmoothCost>
+        double smooth_energy(SmoothCost const & smooth_cost) const;
+        /** Change of the smoothness costs since the labeling previous_labels. */
+        template <typename SmoothCost>
+        double smooth_energy_change(std::vector<int> const & previous_labels,
+            SmoothCost const & smooth_cost) const;
+
+    private:
+        void init_labels(void);
+
+    public:
+        CompressedGraph(int num_sites);
+
+        void set_smooth_cost(SmoothCostFunction func);
+        void set_data_costs(int label, std::vector<SparseDataCost> const & costs);
+        void set_neighbors(int site1, int site2);
+        void set_neighbors(int site1, int site2, ENERGY_TYPE weight);
+        void set_graph(std::vector<std::size_t> const & neighbor_offsets,
+            std::vector<int> const & neighbors, std::vector<std::size_t> const & cost_offsets,
+            std::vector<int> const & site_labels, std::vector<DATA_COST_TYPE> const & costs,
+            std::vector<ENERGY_TYPE> const & weights);
+        ENERGY_TYPE compute_energy();
+        int what_label(int site);
+        void set_label(int site, int label);
+
+        int num_sites();
+};
+
+inline std::size_t
+CompressedGraph::num_labels(int vertex) const {
+    return label_offsets[vertex + 1] - label_offsets[vertex];
+}
+
+inline ENERGY_TYPE
+CompressedGraph::edge_weight(int edge_idx) const {
+    return edge_weights.empty() ? ENERGY_TYPE(1) : edge_weights[edge_idx];
+}
+
+template <typename SmoothCost> double
+CompressedGraph::smooth_energy(SmoothCost const & smooth_cost) const {
+    double energy = 0.0;
+
+    #pragma omp parallel for reduction(+:energy)
+    for (std::size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+        DirectedEdge const & edge = edges[edge_idx];
+        energy += edge_weight(edge_idx)
+            * smooth_cost(edge.v1, edge.v2, vertex_labels[edge.v1], vertex_labels[edge.v2]);
+    }
+
+    return energy;
+}
+
+template <typename SmoothCost> double
+CompressedGraph::smooth_energy_change(std::vector<int> const & previous_labels,
+    SmoothCost const & smooth_cost) const {
+
+    /* Only edges adjacent to relabeled vertices change their smoothness costs. */
+    double delta = 0.0;
+    #pragma omp parallel for reduction(+:delta)
+    for (std::size_t v = 0; v < vertex_labels.size(); ++v) {
+        int const label = vertex_labels[v];
+        int const previous_label = previous_labels[v];
+        if (label == previous_label) continue;
+
+        for (std::size_t n = incoming_offsets[v]; n < incoming_offsets[v + 1]; ++n) {
+            int const edge_idx = incoming_edges[n];
+            int const u = edges[edge_idx].v1;
+            int const neighbor_label = vertex_labels[u];
+            int const previous_neighbor_label = previous_labels[u];
+            /* Count edges between two relabeled vertices once. */
+            if (neighbor_label != previous_neighbor_label && static_cast<std::size_t>(u) < v) continue;
+
+            delta += edge_weight(edge_idx) * (smooth_cost(u, v, neighbor_label, label)
+                + smooth_cost(v, u, label, neighbor_label)
+                - smooth_cost(u, v, previous_neighbor_label, previous_label)
+                - smooth_cost(v, u, previous_label, previous_neighbor_label));
+        }
+    }
+
+    return delta;
+}
+
+MRF_NAMESPACE_END
+
+#endif /* MRF_COMPRESSEDGRAPH_HEADER */
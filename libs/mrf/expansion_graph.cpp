@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "expansion_graph.h"
+
+MRF_NAMESPACE_BEGIN
+
+ExpansionGraph::ExpansionGraph(int num_sites, int) : CompressedGraph(num_sites) {}
+
+void ExpansionGraph::finalize(void) {
+    build_layout();
+    std::size_t const num_vertices = vertex_labels.size();
+
+    /* Sites for which each label is available. */
+    alpha_labels = labels;
+    std::sort(alpha_labels.begin(), alpha_labels.end());
+    alpha_labels.erase(std::unique(alpha_labels.begin(), alpha_labels.end()), alpha_labels.end());
+
+    std::vector<std::size_t> label_indices(labels.size());
+    label_site_offsets.assign(alpha_labels.size() + 1, 0);
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        label_indices[i] = std::lower_bound(alpha_labels.begin(), alpha_labels.end(),
+            labels[i]) - alpha_labels.begin();
+        label_site_offsets[label_indices[i] + 1] += 1;
+    }
+    for (std::size_t i = 0; i < alpha_labels.size(); ++i)
+        label_site_offsets[i + 1] += label_site_offsets[i];
+
+    label_sites.resize(labels.size());
+    label_site_costs.resize(labels.size());
+    std::vector<std::size_t> next(label_site_offsets.begin(), label_site_offsets.end() - 1);
+    for (std::size_t v = 0; v < num_vertices; ++v) {
+        for (std::size_t j = label_offsets[v]; j < label_offsets[v + 1]; ++j) {
+            std::size_t idx = next[label_indices[j]]++;
+            label_sites[idx] = static_cast<int>(v);
+            label_site_costs[idx] = data_costs[j];
+        }
+    }
+
+    site_nodes.assign(num_vertices, -1);
+
+    finalized = true;
+}
+
+/**
+  * Weighted smoothness term of the edge between site1 = edges[edge_idx].v2 and
+  * site2 = edges[edge_idx].v1 - like the other solvers, the energy counts the
+  * smoothness term of an edge in both directions.
+  */
+template <typename SmoothCost> MaxFlow::CapType
+ExpansionGraph::edge_cost(int edge_idx, int label1, int label2,
+    SmoothCost const & smooth_cost) const {
+    int const site1 = edges[edge_idx].v2;
+    int const site2 = edges[edge_idx].v1;
+    return edge_weight(edge_idx) * (smooth_cost(site1, site2, label1, label2)
+        + smooth_cost(site2, site1, label2, label1));
+}
+
+template <typename SmoothCost> bool
+ExpansionGraph::expand(std::size_t label_idx, SmoothCost const & smooth_cost) {
+    int const alpha = alpha_labels[label_idx];
+
+    /* Sites that may switch to alpha become nodes of the cut graph. */
+    node_sites.clear();
+    node_label_costs.clear();
+    for (std::size_t i = label_site_offsets[label_idx]; i < label_site_offsets[label_idx + 1]; ++i) {
+        int site = label_sites[i];
+        if (vertex_labels[site] == alpha) continue;
+        site_nodes[site] = static_cast<int>(node_sites.size());
+        node_sites.push_back(site);
+        node_label_costs.push_back(label_site_costs[i]);
+    }
+
+    int const num_nodes = static_cast<int>(node_sites.size());
+    if (num_nodes == 0) return false;
+
+    /* Variable value 0: keep the current label, 1: switch to alpha. */
+    maxflow.reset(num_nodes);
+    for (int node = 0; node < num_nodes; ++node) {
+        int site = node_sites[node];
+        int label = vertex_labels[site];
+        MaxFlow::CapType e0 = vertex_data_costs[site];
+        MaxFlow::CapType e1 = node_label_costs[node];
+
+        for (std::size_t n = incoming_offsets[site]; n < incoming_offsets[site + 1]; ++n) {
+            int edge_idx = incoming_edges[n];
+            int neighbor = edges[edge_idx].v1;
+            int neighbor_label = vertex_labels[neighbor];
+            int neighbor_node = site_nodes[neighbor];
+            if (neighbor_node < 0) {
+                /* Neighbor label is fixed - the pairwise term becomes unary. */
+                e0 += edge_cost(edge_idx, label, neighbor_label, smooth_cost);
+                e1 += edge_cost(edge_idx, alpha, neighbor_label, smooth_cost);
+            } else if (node < neighbor_node) {
+                MaxFlow::CapType const a = edge_cost(edge_idx, label, neighbor_label, smooth_cost);
+                MaxFlow::CapType const b = edge_cost(edge_idx, label, alpha, smooth_cost);
+                MaxFlow::CapType const c = edge_cost(edge_idx, alpha, neighbor_label, smooth_cost);
+                MaxFlow::CapType d = edge_cost(edge_idx, alpha, alpha, smooth_cost);
+                /* Truncate non-regular (non-metric) terms, the move is still
+                 * evaluated with the actual energy below. */
+                if (b + c - a - d < 0) d = b + c - a;
+                maxflow.add_term2(node, neighbor_node, a, b, c, d);
+            }
+        }
+
+        maxflow.add_term1(node, e0, e1);
+    }
+
+    maxflow.maxflow();
+
+    /* Energy change of the move. */
+    MaxFlow::CapType delta = 0;
+    for (int node = 0; node < num_nodes; ++node) {
+        if (!maxflow.in_sink_segment(node)) continue;
+
+        int site = node_sites[node];
+        int label = vertex_labels[site];
+        delta += node_label_costs[node] - vertex_data_costs[site];
+
+        for (std::size_t n = incoming_offsets[site]; n < incoming_offsets[site + 1]; ++n) {
+            int edge_idx = incoming_edges[n];
+            int neighbor = edges[edge_idx].v1;
+            int neighbor_label = vertex_labels[neighbor];
+            int neighbor_node = site_nodes[neighbor];
+            bool neighbor_moves = neighbor_node >= 0 && maxflow.in_sink_segment(neighbor_node);
+            /* Count edges between two moving sites once. */
+            if (neighbor_moves && neighbor_node < node) continue;
+
+            int new_neighbor_label = neighbor_moves ? alpha : neighbor_label;
+            delta += edge_cost(edge_idx, alpha, new_neighbor_label, smooth_cost)
+                - edge_cost(edge_idx, label, neighbor_label, smooth_cost);
+        }
+    }
+
+    bool const improved = delta < 0;
+    if (improved) current_energy += delta;
+    for (int node = 0; node < num_nodes; ++node) {
+        int site = node_sites[node];
+        if (improved && maxflow.in_sink_segment(node)) {
+            vertex_labels[site] = alpha;
+            vertex_data_costs[site] = node_label_costs[node];
+        }
+        site_nodes[site] = -1;
+    }
+
+    return improved;
+}
+
+ENERGY_TYPE ExpansionGraph::optimize(int num_iterations) {
+    if (!finalized) finalize();
+    if (!energy_valid) compute_energy();
+
+    bool const potts_model = smooth_cost_func == potts;
+    FunctionSmoothCost const function_smooth_cost(smooth_cost_func);
+
+    for (int i = 0; i < num_iterations; ++i) {
+        bool changed = false;
+        for (std::size_t label_idx = 0; label_idx < alpha_labels.size(); ++label_idx) {
+            bool const expanded = potts_model
+                ? expand(label_idx, PottsSmoothCost())
+                : expand(label_idx, function_smooth_cost);
+            changed = expanded || changed;
+        }
+        if (!changed) break;
+    }
+
+    return static_cast<ENERGY_TYPE>(current_energy);
+}
+
+MRF_NAMESPACE_END
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef MRF_EXPANSIONGRAPH_HEADER
+#define MRF_EXPANSIONGRAPH_HEADER
+
+#include <cstddef>
+
+#include "compressed_graph.h"
+#include "maxflow.h"
+
+MRF_NAMESPACE_BEGIN
+
+/**
+  * Implementation of the alpha-expansion algorithm (Boykov, Veksler and Zabih,
+  * "Fast Approximate Energy Minimization via Graph Cuts", PAMI 2001).
+  * Each iteration expands every label once, each expansion move is computed
+  * with a minimum cut (MaxFlow) restricted to the sites for which the label is
+  * available. For non-metric smoothness terms the non-regular pairwise terms of
+  * a move are truncated (Rother et al., "Digital Tapestry", CVPR 2005) - the
+  * move is then only approximately optimal. Moves that would not decrease the
+  * actual energy are rejected, which keeps the optimization monotone.
+  *
+  * The graph is stored in the compressed layout of CompressedGraph, the
+  * sites for which each label is available are collected on the first call
+  * of optimize. The smoothness term of each edge is counted in both directions.
+  */
+class ExpansionGraph : public CompressedGraph {
+    private:
+        /* Sites (and their data costs) for which alpha_labels[i] is available:
+         * [label_site_offsets[i], label_site_offsets[i + 1]). */
+        std::vector<int> alpha_labels;
+        std::vector<std::size_t> label_site_offsets;
+        std::vector<int> label_sites;
+        std::vector<DATA_COST_TYPE> label_site_costs;
+
+        /* Per expansion move: node of each site in the cut graph (or -1). */
+        std::vector<int> site_nodes;
+        std::vector<int> node_sites;
+        std::vector<DATA_COST_TYPE> node_label_costs;
+        MaxFlow maxflow;
+
+        void finalize(void);
+        template <typename SmoothCost>
+        MaxFlow::CapType edge_cost(int edge_idx, int label1, int label2,
+            SmoothCost const & smooth_cost) const;
+        template <typename SmoothCost>
+        bool expand(std::size_t label_idx, SmoothCost const & smooth_cost);
+
+    public:
+        ExpansionGraph(int num_sites, int num_labels);
+
+        ENERGY_TYPE optimize(int num_iterations);
+};
+
+MRF_NAMESPACE_END
+
+#endif /* MRF_EXPANSIONGRAPH_HEADER */
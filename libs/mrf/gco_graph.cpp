@@ -7,6 +7,7 @@
  * of the BSD 3-Clause license. See the LICENSE.txt file for details.
  */
 
+#include <cmath>
 #include <iostream>
 #include <algorithm>
 
@@ -15,7 +16,8 @@
 MRF_NAMESPACE_BEGIN
 
 #ifdef RESEARCH
-GCOGraph::GCOGraph(int num_sites, int num_lables) : gco(num_sites, num_lables) {
+GCOGraph::GCOGraph(int num_sites, int num_lables) : gco(num_sites, num_lables),
+    site_labels(num_sites), best_labels(num_sites, -1), best_costs(num_sites, MRF_MAX_ENERGYTERM) {
     /* GCoptimization uses rand() to create a random label order
      * - specify seed for repeadability. */
     srand(9313513);
@@ -35,7 +37,16 @@ void GCOGraph::set_data_costs(int label, std::vector<SparseDataCost> const & cos
     /* Sparse data costs must be sorted in increasing order of site ID */
     std::vector<GCoptimization::SparseDataCost> gcocosts(costs.size());
     for (std::size_t i = 0; i < costs.size(); ++i) {
-        gcocosts[i] = {costs[i].site, costs[i].cost};
+        int const site = costs[i].site;
+        DATA_COST_TYPE const cost = costs[i].cost;
+        gcocosts[i] = {site, cost};
+
+        site_labels[site].push_back(label);
+        if (best_labels[site] < 0 || cost < best_costs[site]
+            || (cost == best_costs[site] && label < best_labels[site])) {
+            best_labels[site] = label;
+            best_costs[site] = cost;
+        }
     }
     std::sort(gcocosts.begin(), gcocosts.end(), comp_spd_site);
     try {
@@ -63,10 +74,33 @@ void GCOGraph::set_neighbors(int site1, int site2) {
     gco.setNeighbors(site1, site2);
 }
 
+void GCOGraph::set_neighbors(int site1, int site2, ENERGY_TYPE weight) {
+    /* GCoptimization takes integral weights - rounding would change the energy. */
+    if (weight != std::round(weight)) {
+        std::cerr << "GCO does not support fractional edge weights" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    gco.setNeighbors(site1, site2, static_cast<GCoptimization::EnergyTermType>(weight));
+}
+
 int GCOGraph::what_label(int site) {
     return static_cast<int>(gco.whatLabel(site));
 }
 
+void GCOGraph::set_label(int site, int label) {
+    /* Labels which are not available for the site would get GCO's default data cost. */
+    std::vector<int> const & labels = site_labels[site];
+    if (!labels.empty() && std::find(labels.begin(), labels.end(), label) == labels.end()) {
+        label = best_labels[site];
+    }
+    try {
+        gco.setLabel(site, label);
+    } catch (GCException e) {
+        std::cerr << e.message << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
 int GCOGraph::num_sites() {
     return static_cast<int>(gco.numSites());
 }
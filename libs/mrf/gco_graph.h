@@ -21,6 +21,11 @@ MRF_NAMESPACE_BEGIN
 class GCOGraph : public Graph {
     private:
         GCoptimizationGeneralGraph gco;
+        /* Labels of each site and the one with the lowest data cost (lower label
+         * on ties, -1 if none), set_label falls back to it like the other solvers. */
+        std::vector<std::vector<int> > site_labels;
+        std::vector<int> best_labels;
+        std::vector<DATA_COST_TYPE> best_costs;
 
     public:
         GCOGraph(int num_sites, int num_lables);
@@ -28,9 +33,11 @@ class GCOGraph : public Graph {
         void set_smooth_cost(SmoothCostFunction func);
         void set_data_costs(int label, std::vector<SparseDataCost> const & costs);
         void set_neighbors(int site1, int site2);
+        void set_neighbors(int site1, int site2, ENERGY_TYPE weight);
         ENERGY_TYPE compute_energy();
         ENERGY_TYPE optimize(int num_iterations);
         int what_label(int site);
+        void set_label(int site, int label);
 
         int num_sites();
         int num_labels();
@@ -9,15 +9,64 @@
 
 #include "icm_graph.h"
 #include "lbp_graph.h"
+#include "expansion_graph.h"
+#include "trws_graph.h"
 #include "gco_graph.h"
 #include "graph.h"
 
 MRF_NAMESPACE_BEGIN
 
+ENERGY_TYPE potts(int s1, int s2, int l1, int l2) {
+    return PottsSmoothCost()(s1, s2, l1, l2);
+}
+
+void Graph::set_graph(std::vector<std::size_t> const & neighbor_offsets,
+    std::vector<int> const & neighbors, std::vector<std::size_t> const & cost_offsets,
+    std::vector<int> const & labels, std::vector<DATA_COST_TYPE> const & costs,
+    std::vector<ENERGY_TYPE> const & weights) {
+
+    int const num_sites = static_cast<int>(neighbor_offsets.size()) - 1;
+    for (int site = 0; site < num_sites; ++site) {
+        for (std::size_t i = neighbor_offsets[site]; i < neighbor_offsets[site + 1]; ++i) {
+            if (site >= neighbors[i]) continue;
+            if (weights.empty()) {
+                set_neighbors(site, neighbors[i]);
+            } else {
+                set_neighbors(site, neighbors[i], weights[i]);
+            }
+        }
+    }
+
+    std::vector<std::vector<SparseDataCost> > label_costs;
+    for (int site = 0; site < num_sites; ++site) {
+        for (std::size_t i = cost_offsets[site]; i < cost_offsets[site + 1]; ++i) {
+            std::size_t const label = labels[i];
+            if (label >= label_costs.size()) label_costs.resize(label + 1);
+            label_costs[label].push_back({site, costs[i]});
+        }
+    }
+    for (std::size_t label = 0; label < label_costs.size(); ++label) {
+        if (label_costs[label].empty()) continue;
+        set_data_costs(static_cast<int>(label), label_costs[label]);
+    }
+}
+
+bool Graph::supports_fractional_weights(SOLVER_TYPE solver_type) {
+    switch (solver_type) {
+        #ifdef RESEARCH
+        case GCO: return false;
+        #endif
+        default: return true;
+    }
+}
+
 Graph::Ptr Graph::create(int num_sites, int num_labels, SOLVER_TYPE solver_type) {
     switch (solver_type) {
         case ICM: return Graph::Ptr(new ICMGraph(num_sites, num_labels));
         case LBP: return Graph::Ptr(new LBPGraph(num_sites, num_labels));
+        case EXPANSION: return Graph::Ptr(new ExpansionGraph(num_sites, num_labels));
+        case RESIDUAL_LBP: return Graph::Ptr(new LBPGraph(num_sites, num_labels, LBPGraph::RESIDUAL));
+        case TRWS: return Graph::Ptr(new TRWSGraph(num_sites, num_labels));
         #ifdef RESEARCH
         case GCO: return Graph::Ptr(new GCOGraph(num_sites, num_labels));
         #endif
@@ -10,26 +10,76 @@
 #ifndef MRF_GRAPH_HEADER
 #define MRF_GRAPH_HEADER
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
-#define MRF_MAX_ENERGYTERM 10000000
+/* Largest data cost (16 bit) and cost of a label change in the Potts model. */
+#define MRF_MAX_ENERGYTERM 65535
 #define MRF_NAMESPACE_BEGIN namespace mrf {
 #define MRF_NAMESPACE_END }
 
 MRF_NAMESPACE_BEGIN
 
 typedef float ENERGY_TYPE;
+/* Data costs are stored with 16 bit, energies and messages as ENERGY_TYPE. */
+typedef std::uint16_t DATA_COST_TYPE;
 typedef ENERGY_TYPE (*SmoothCostFunction)(int s1, int s2, int l1, int l2);
 
 struct SparseDataCost {
     int site;
-    ENERGY_TYPE cost;
+    DATA_COST_TYPE cost;
+};
+
+/** Adds two data costs, saturating at MRF_MAX_ENERGYTERM. */
+inline DATA_COST_TYPE
+saturating_add(DATA_COST_TYPE cost1, DATA_COST_TYPE cost2) {
+    unsigned int const sum = static_cast<unsigned int>(cost1) + cost2;
+    return static_cast<DATA_COST_TYPE>(sum < MRF_MAX_ENERGYTERM ? sum : MRF_MAX_ENERGYTERM);
+}
+
+/** Rounds a cost to the closest data cost, saturating at 0 and MRF_MAX_ENERGYTERM. */
+inline DATA_COST_TYPE
+saturating_cast(double cost) {
+    if (!(cost > 0.0)) return 0;
+    if (cost >= MRF_MAX_ENERGYTERM) return MRF_MAX_ENERGYTERM;
+    return static_cast<DATA_COST_TYPE>(std::round(cost));
+}
+
+/**
+  * Potts model: no cost for equal labels, MRF_MAX_ENERGYTERM otherwise.
+  * The label 0 (undefined) does not agree with any label, not even itself.
+  * Solvers may detect this function and use specialized updates.
+  */
+ENERGY_TYPE potts(int s1, int s2, int l1, int l2);
+
+/**
+  * Smoothness cost functors for the solver cores, which are templated on the
+  * functor type: PottsSmoothCost is inlined, FunctionSmoothCost wraps any
+  * SmoothCostFunction as generic fallback.
+  */
+struct PottsSmoothCost {
+    ENERGY_TYPE operator()(int, int, int l1, int l2) const {
+        return l1 == l2 && l1 != 0 ? 0 : MRF_MAX_ENERGYTERM;
+    }
+};
+
+struct FunctionSmoothCost {
+    SmoothCostFunction func;
+    explicit FunctionSmoothCost(SmoothCostFunction func) : func(func) {}
+    ENERGY_TYPE operator()(int s1, int s2, int l1, int l2) const {
+        return func(s1, s2, l1, l2);
+    }
 };
 
 enum SOLVER_TYPE {
     ICM,
     LBP,
+    EXPANSION,
+    RESIDUAL_LBP,
+    TRWS,
     #ifdef RESEARCH
     GCO
     #endif
@@ -42,12 +92,42 @@ public:
     virtual void set_smooth_cost(SmoothCostFunction func) = 0;
     virtual void set_data_costs(int label, std::vector<SparseDataCost> const & costs) = 0;
     virtual void set_neighbors(int site1, int site2) = 0;
+    /** Like set_neighbors, the smoothness term of the edge is scaled by weight. */
+    virtual void set_neighbors(int site1, int site2, ENERGY_TYPE weight) = 0;
+    /**
+      * Sets the neighbors and data costs of all sites at once (instead of
+      * calling set_neighbors and set_data_costs), given in a compressed layout:
+      * The neighbors of site s are neighbors[neighbor_offsets[s], neighbor_offsets[s + 1]),
+      * each edge has to be listed for both of its sites. The labels of site s
+      * and their data costs are labels[cost_offsets[s], cost_offsets[s + 1])
+      * and costs[cost_offsets[s], cost_offsets[s + 1]).
+      * If given, weights[i] scales the smoothness term of the edge to neighbors[i]
+      * and has to be the same for both sites of the edge.
+      * Solvers with a compressed layout adopt these arrays directly, the
+      * default implementation issues the corresponding set_* calls.
+      */
+    virtual void set_graph(std::vector<std::size_t> const & neighbor_offsets,
+        std::vector<int> const & neighbors, std::vector<std::size_t> const & cost_offsets,
+        std::vector<int> const & labels, std::vector<DATA_COST_TYPE> const & costs,
+        std::vector<ENERGY_TYPE> const & weights = std::vector<ENERGY_TYPE>());
+    /**
+      * Returns the energy of the current labeling - the data costs plus the
+      * smoothness term of each edge in both directions.
+      */
     virtual ENERGY_TYPE compute_energy() = 0;
     virtual ENERGY_TYPE optimize(int num_iterations) = 0;
     virtual int what_label(int site) = 0;
+    /**
+      * Sets the current label of a site, e.g. to initialize the optimization.
+      * Has to be called after all data costs are set, labels which are not
+      * available for the site are replaced by the one with the lowest data cost.
+      */
+    virtual void set_label(int site, int label) = 0;
     virtual int num_sites() = 0;
 
     static Graph::Ptr create(int num_sites, int num_labels, SOLVER_TYPE solver_type);
+    /** Returns whether the solver supports edge weights which are not integral. */
+    static bool supports_fractional_weights(SOLVER_TYPE solver_type);
 };
 
 MRF_NAMESPACE_END
@@ -13,75 +13,121 @@
 
 MRF_NAMESPACE_BEGIN
 
-ICMGraph::ICMGraph(int num_sites, int) :
-    sites(num_sites) {}
-
-ENERGY_TYPE ICMGraph::compute_energy() {
-    ENERGY_TYPE energy = 0;
-    for (std::size_t i = 0; i < sites.size(); ++i) {
-        Site const & site = sites[i];
-        energy += site.data_cost + smooth_cost(i, site.label);
-    }
-    return energy;
+ICMGraph::ICMGraph(int num_sites, int) : CompressedGraph(num_sites) {}
+
+void ICMGraph::finalize(void) {
+    build_layout();
+    color_sites_greedy();
+    finalized = true;
 }
 
-ENERGY_TYPE ICMGraph::optimize(int num_iterations) {
-    for (int i = 0; i < num_iterations; ++i) {
-        for (std::size_t j = 0; j < sites.size(); ++j) {
-            Site * site = &sites[j];
-            /* Current cost */
-            ENERGY_TYPE min_cost = std::numeric_limits<ENERGY_TYPE>::max(); //site->data_cost + smooth_cost(j, site->label);
-            for (std::size_t k = 0; k < site->labels.size(); ++k) {
-                ENERGY_TYPE cost = site->data_costs[k] + smooth_cost(j, site->labels[k]);
-                if (cost < min_cost) {
-                    min_cost = cost;
-                    site->data_cost = site->data_costs[k];
-                    site->label = site->labels[k];
-                }
-            }
+void ICMGraph::color_sites_greedy(void) {
+    std::size_t const num_vertices = vertex_labels.size();
+    std::vector<int> colors(num_vertices, -1);
+    std::vector<int> used(1, -1);
+    int num_colors = 0;
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        for (std::size_t n = incoming_offsets[i]; n < incoming_offsets[i + 1]; ++n) {
+            int const neighbor = edges[incoming_edges[n]].v1;
+            if (colors[neighbor] >= 0) used[colors[neighbor]] = static_cast<int>(i);
         }
+        int color = 0;
+        while (color < num_colors && used[color] == static_cast<int>(i)) ++color;
+        if (color == num_colors) {
+            num_colors += 1;
+            used.push_back(-1);
+        }
+        colors[i] = color;
     }
-    return compute_energy();
-}
 
-void ICMGraph::set_smooth_cost(SmoothCostFunction func) {
-    smooth_cost_func = func;
-}
+    color_offsets.assign(num_colors + 1, 0);
+    for (int color : colors) color_offsets[color + 1] += 1;
+    for (int c = 0; c < num_colors; ++c) color_offsets[c + 1] += color_offsets[c];
 
-void ICMGraph::set_neighbors(int site1, int site2) {
-    sites[site1].neighbors.push_back(site2);
-    sites[site2].neighbors.push_back(site1);
+    color_sites.resize(num_vertices);
+    std::vector<std::size_t> next(color_offsets.begin(), color_offsets.end() - 1);
+    for (std::size_t i = 0; i < num_vertices; ++i)
+        color_sites[next[colors[i]]++] = static_cast<int>(i);
 }
 
+ENERGY_TYPE ICMGraph::optimize(int num_iterations) {
+    if (!finalized) finalize();
+    if (!energy_valid) compute_energy();
 
-void ICMGraph::set_data_costs(int label, std::vector<SparseDataCost> const & costs) {
-    for (std::size_t i = 0; i < costs.size(); ++i) {
-        Site & site = sites[costs[i].site];
-        site.labels.push_back(label);
-        int data_cost = costs[i].cost;
-        site.data_costs.push_back(data_cost);
+    if (smooth_cost_func == potts) {
+        iterate(num_iterations, PottsSmoothCost());
+    } else {
+        iterate(num_iterations, FunctionSmoothCost(smooth_cost_func));
+    }
+    return static_cast<ENERGY_TYPE>(current_energy);
+}
 
-        if (data_cost < site.data_cost) {
-            site.label = label;
-            site.data_cost = data_cost;
+template <typename SmoothCost> void
+ICMGraph::iterate(int num_iterations, SmoothCost const & smooth_cost) {
+    std::size_t const num_colors = color_offsets.size() - 1;
+    for (int i = 0; i < num_iterations; ++i) {
+        for (std::size_t c = 0; c < num_colors; ++c) {
+            /* Sites of the same color are not adjacent - their updates are independent. */
+            double delta = 0.0;
+            #pragma omp parallel for schedule(dynamic, 1024) reduction(+:delta)
+            for (std::size_t j = color_offsets[c]; j < color_offsets[c + 1]; ++j) {
+                delta += update_site(color_sites[j], smooth_cost);
+            }
+            current_energy += delta;
         }
     }
 }
 
-int ICMGraph::what_label(int site) {
-    return sites[site].label;
+template <typename SmoothCost> double
+ICMGraph::update_site(int site, SmoothCost const & smooth_cost) {
+    int const label = vertex_labels[site];
+    int const data_cost = vertex_data_costs[site];
+
+    ENERGY_TYPE min_cost = std::numeric_limits<ENERGY_TYPE>::max();
+    for (std::size_t j = label_offsets[site]; j < label_offsets[site + 1]; ++j) {
+        ENERGY_TYPE cost = data_costs[j] + this->smooth_cost(site, labels[j], smooth_cost);
+        if (cost < min_cost) {
+            min_cost = cost;
+            vertex_labels[site] = labels[j];
+            vertex_data_costs[site] = data_costs[j];
+        }
+    }
+
+    /* The energy counts the edges of the site from both sides. */
+    int const new_label = vertex_labels[site];
+    if (new_label == label) return 0.0;
+    return vertex_data_costs[site] - data_cost
+        + this->smooth_cost(site, new_label, smooth_cost)
+        - this->smooth_cost(site, label, smooth_cost)
+        + reverse_smooth_cost(site, new_label, smooth_cost)
+        - reverse_smooth_cost(site, label, smooth_cost);
 }
 
 ENERGY_TYPE ICMGraph::smooth_cost(int site, int label) {
-    ENERGY_TYPE smooth_cost = 0;
-    for (int neighbor : sites[site].neighbors) {
-         smooth_cost += smooth_cost_func(site, neighbor, label, sites[neighbor].label);
+    if (!finalized) finalize();
+    return smooth_cost(site, label, FunctionSmoothCost(smooth_cost_func));
+}
+
+template <typename SmoothCost> ENERGY_TYPE
+ICMGraph::smooth_cost(int site, int label, SmoothCost const & smooth_cost) const {
+    ENERGY_TYPE cost = 0;
+    for (std::size_t n = incoming_offsets[site]; n < incoming_offsets[site + 1]; ++n) {
+        int const edge_idx = incoming_edges[n];
+        int const neighbor = edges[edge_idx].v1;
+        cost += edge_weight(edge_idx) * smooth_cost(site, neighbor, label, vertex_labels[neighbor]);
     }
-    return smooth_cost;
+    return cost;
 }
 
-int ICMGraph::num_sites() {
-    return static_cast<int>(sites.size());
+template <typename SmoothCost> ENERGY_TYPE
+ICMGraph::reverse_smooth_cost(int site, int label, SmoothCost const & smooth_cost) const {
+    ENERGY_TYPE cost = 0;
+    for (std::size_t n = incoming_offsets[site]; n < incoming_offsets[site + 1]; ++n) {
+        int const edge_idx = incoming_edges[n];
+        int const neighbor = edges[edge_idx].v1;
+        cost += edge_weight(edge_idx) * smooth_cost(neighbor, site, vertex_labels[neighbor], label);
+    }
+    return cost;
 }
 
 MRF_NAMESPACE_END
@@ -10,36 +10,43 @@
 #ifndef MRF_ICMGRAPH_HEADER
 #define MRF_ICMGRAPH_HEADER
 
-#include "graph.h"
+#include "compressed_graph.h"
 
 MRF_NAMESPACE_BEGIN
 
-/** Implementation of the iterated conditional mode algrorithm. */
-class ICMGraph : public Graph {
+/**
+  * Implementation of the iterated conditional mode algrorithm.
+  * Sites are greedily colored such that no neighbors share a color, the
+  * sites of each color are updated in parallel. The graph is stored in the
+  * compressed layout of CompressedGraph.
+  */
+class ICMGraph : public CompressedGraph {
     private:
-        struct Site {
-            int label;
-            int data_cost;
-            std::vector<int> labels;
-            std::vector<int> data_costs;
-            std::vector<int> neighbors;
-            Site() : label(0), data_cost(MRF_MAX_ENERGYTERM) {}
-        };
-
-        std::vector<Site> sites;
-        SmoothCostFunction smooth_cost_func;
+        /* Sites of color c: [color_offsets[c], color_offsets[c + 1]). */
+        std::vector<std::size_t> color_offsets;
+        std::vector<int> color_sites;
+
+        void finalize(void);
+
+        /* Smoothness costs of the edges from site towards its neighbors. */
+        template <typename SmoothCost>
+        ENERGY_TYPE smooth_cost(int site, int label, SmoothCost const & smooth_cost) const;
+        /* Smoothness costs of the edges from the neighbors towards site. */
+        template <typename SmoothCost>
+        ENERGY_TYPE reverse_smooth_cost(int site, int label, SmoothCost const & smooth_cost) const;
+
+        template <typename SmoothCost>
+        void iterate(int num_iterations, SmoothCost const & smooth_cost);
+
+        void color_sites_greedy(void);
+        /** Sets the locally optimal label of the site and returns the change of energy. */
+        template <typename SmoothCost>
+        double update_site(int site, SmoothCost const & smooth_cost);
     public:
         ICMGraph(int num_sites, int num_labels);
         ENERGY_TYPE smooth_cost(int site, int label);
 
-        void set_smooth_cost(SmoothCostFunction func);
-        void set_data_costs(int label, std::vector<SparseDataCost> const & costs);
-        void set_neighbors(int site1, int site2);
-        ENERGY_TYPE compute_energy();
         ENERGY_TYPE optimize(int num_iterations);
-        int what_label(int site);
-
-        int num_sites();
 };
 
 MRF_NAMESPACE_END
@@ -8,131 +8,236 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
 #include <limits>
+#include <random>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "lbp_graph.h"
+#include "message.h"
 
 MRF_NAMESPACE_BEGIN
 
-LBPGraph::LBPGraph(int num_sites, int) :
-    vertices(num_sites) {}
+LBPGraph::LBPGraph(int num_sites, int, Schedule schedule) :
+    CompressedGraph(num_sites), schedule(schedule) {}
+
+void LBPGraph::finalize(void) {
+    build_layout();
+
+    /* Messages - sized once for all edges. */
+    init_message_offsets(&msg_offsets);
+    old_msgs.assign(msg_offsets.back(), 0);
+    new_msgs.assign(msg_offsets.back(), 0);
 
-ENERGY_TYPE LBPGraph::compute_energy() {
-    ENERGY_TYPE energy = 0;
+    if (labels_set) init_certain_messages(msg_offsets, &old_msgs);
+
+    finalized = true;
+}
 
-    #pragma omp parallel for reduction(+:energy)
-    for (std::size_t vertex_idx = 0; vertex_idx < vertices.size(); ++vertex_idx) {
-        Vertex const & vertex = vertices[vertex_idx];
-        energy += vertex.data_cost;
+void LBPGraph::compute_message(std::size_t edge_idx, bool potts_model,
+    std::vector<ENERGY_TYPE> * partial_energies) {
+
+    DirectedEdge const & edge = edges[edge_idx];
+    std::size_t const num_labels1 = num_labels(edge.v1);
+
+    /* Data cost plus all incoming messages except the one from v2 for each label of v1. */
+    DATA_COST_TYPE const * costs1 = data_costs.data() + label_offsets[edge.v1];
+    partial_energies->assign(costs1, costs1 + num_labels1);
+    for (std::size_t n = incoming_offsets[edge.v1]; n < incoming_offsets[edge.v1 + 1]; ++n) {
+        int pre_edge_idx = incoming_edges[n];
+        if (edges[pre_edge_idx].v1 == edge.v2) continue;
+        ENERGY_TYPE const * pre_msg = old_msgs.data() + msg_offsets[pre_edge_idx];
+        for (std::size_t k = 0; k < num_labels1; ++k)
+            (*partial_energies)[k] += pre_msg[k];
     }
 
-    #pragma omp parallel for reduction(+:energy)
-    for (std::size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
-        DirectedEdge const & edge = edges[edge_idx];
-        energy += smooth_cost_func(edge.v1, edge.v2, vertices[edge.v1].label, vertices[edge.v2].label);
+    int const * labels1 = labels.data() + label_offsets[edge.v1];
+    int const * labels2 = labels.data() + label_offsets[edge.v2];
+    std::size_t const num_labels2 = num_labels(edge.v2);
+    ENERGY_TYPE const weight = edge_weight(static_cast<int>(edge_idx));
+    ENERGY_TYPE * msg = new_msgs.data() + msg_offsets[edge_idx];
+    if (potts_model) {
+        potts_message(labels1, num_labels1, partial_energies->data(),
+            labels2, num_labels2, weight, msg);
+    } else {
+        generic_message(edge.v1, edge.v2, FunctionSmoothCost(smooth_cost_func),
+            labels1, num_labels1, partial_energies->data(),
+            labels2, num_labels2, weight, msg);
     }
+    normalize_message(msg, msg + num_labels2);
+}
 
-    return energy;
+ENERGY_TYPE LBPGraph::residual(std::size_t edge_idx) const {
+    ENERGY_TYPE residual = 0;
+    for (std::size_t j = msg_offsets[edge_idx]; j < msg_offsets[edge_idx + 1]; ++j)
+        residual = std::max(residual, std::abs(new_msgs[j] - old_msgs[j]));
+    return residual;
 }
 
-ENERGY_TYPE LBPGraph::optimize(int num_iterations) {
+void LBPGraph::flooding_iterations(int num_iterations) {
+    bool const potts_model = smooth_cost_func == potts;
+
     for (int i = 0; i < num_iterations; ++i) {
-        #pragma omp parallel for
-        for (std::size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
-            DirectedEdge & edge = edges[edge_idx];
-            std::vector<int> const & labels1 = vertices[edge.v1].labels;
-            std::vector<int> const & labels2 = vertices[edge.v2].labels;
-            for (std::size_t j = 0; j < labels2.size(); ++j) {
-                int label2 = labels2[j];
-                ENERGY_TYPE min_energy = std::numeric_limits<ENERGY_TYPE>::max();
-                for (std::size_t k = 0; k < labels1.size(); ++k) {
-                    int label1 = labels1[k];
-                    ENERGY_TYPE energy = smooth_cost_func(edge.v1, edge.v2, label1, label2) + vertices[edge.v1].data_costs[k];
-
-                    std::vector<int> const& incoming_edges1 = vertices[edge.v1].incoming_edges;
-                    for (std::size_t n = 0; n < incoming_edges1.size(); ++n) {
-                        DirectedEdge const& pre_edge = edges[incoming_edges1[n]];
-                        if (pre_edge.v1 == edge.v2) continue;
-                        energy += pre_edge.old_msg[k];
-                    }
-
-                    if (energy < min_energy)
-                        min_energy = energy;
-                }
-                edge.new_msg[j] = min_energy;
+        #pragma omp parallel
+        {
+            std::vector<ENERGY_TYPE> partial_energies;
+
+            #pragma omp for
+            for (std::size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+                compute_message(edge_idx, potts_model, &partial_energies);
             }
         }
 
-        #pragma omp parallel for
-        for (std::size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
-            DirectedEdge & edge = edges[edge_idx];
-            edge.new_msg.swap(edge.old_msg);
-            ENERGY_TYPE min_msg = std::numeric_limits<ENERGY_TYPE>::max();
-            for (ENERGY_TYPE msg : edge.old_msg)
-               min_msg = std::min(min_msg, msg);
-            for (ENERGY_TYPE &msg : edge.old_msg)
-               msg -= min_msg;
-        }
+        old_msgs.swap(new_msgs);
     }
+}
 
-    #pragma omp parallel for
-    for (std::size_t vertex_idx = 0; vertex_idx < vertices.size(); ++vertex_idx) {
-        Vertex & vertex = vertices[vertex_idx];
-        ENERGY_TYPE min_energy = std::numeric_limits<ENERGY_TYPE>::max();
-        for (std::size_t j = 0; j < vertex.labels.size(); ++j) {
-            ENERGY_TYPE energy = vertex.data_costs[j];
-            for (int incoming_edge_idx : vertex.incoming_edges) {
-                energy += edges[incoming_edge_idx].old_msg[j];
-            }
-            if (energy < min_energy) {
-                min_energy = energy;
-                vertex.label = vertex.labels[j];
-                vertex.data_cost = vertex.data_costs[j];
-            }
+void LBPGraph::init_residual_schedule(void) {
+    bool const potts_model = smooth_cost_func == potts;
+#ifdef _OPENMP
+    std::size_t const num_threads = omp_get_max_threads();
+#else
+    std::size_t const num_threads = 1;
+#endif
+
+    queue.reset(new MultiQueue(4 * num_threads));
+    vertex_locks.reset(new std::mutex[NUM_VERTEX_LOCKS]);
+    stamps.assign(edges.size(), 0);
+
+    std::atomic<unsigned int> seed(0);
+    #pragma omp parallel
+    {
+        std::minstd_rand rng(++seed);
+        std::vector<ENERGY_TYPE> partial_energies;
+
+        #pragma omp for
+        for (std::size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+            compute_message(edge_idx, potts_model, &partial_energies);
+            ENERGY_TYPE priority = residual(edge_idx);
+            if (priority > 0)
+                queue->push({priority, static_cast<int>(edge_idx), 0}, &rng);
         }
     }
-
-    return compute_energy();
-}
-
-void LBPGraph::set_smooth_cost(SmoothCostFunction func) {
-    smooth_cost_func = func;
 }
 
-void LBPGraph::set_neighbors(int site1, int site2){
-    edges.push_back(DirectedEdge(site1, site2));
-    vertices[site2].incoming_edges.push_back(edges.size() - 1);
-    edges.push_back(DirectedEdge(site2, site1));
-    vertices[site1].incoming_edges.push_back(edges.size() - 1);
-}
+/**
+  * Residual belief propagation (Elidan, McGraw and Koller, "Residual Belief
+  * Propagation: Informed Scheduling for Asynchronous Message Passing", UAI 2006):
+  * new_msgs holds the pending message of each edge, the edge whose pending
+  * message differs most from its current message is committed next and the
+  * messages depending on it are recomputed.
+  *
+  * The pending message and stamp of an edge are guarded by the lock of its
+  * source vertex, the current message by the lock of its target vertex.
+  */
+void LBPGraph::residual_updates(std::size_t num_updates) {
+    bool const potts_model = smooth_cost_func == potts;
+
+    std::atomic<std::size_t> updates(0);
+    std::atomic<std::size_t> active(0);
+    std::atomic<unsigned int> seed(0);
+    #pragma omp parallel
+    {
+        std::minstd_rand rng(++seed);
+        std::vector<ENERGY_TYPE> partial_energies;
+
+        while (updates < num_updates) {
+            MultiQueue::Entry entry;
+            active += 1;
+            if (!queue->pop(&entry, &rng)) {
+                active -= 1;
+                /* Pops may fail spuriously - stop only if no thread may still
+                 * push entries and all heaps are indeed empty. */
+                if (active == 0 && queue->empty()) break;
+                continue;
+            }
 
+            std::size_t const edge_idx = entry.item;
+            DirectedEdge const & edge = edges[edge_idx];
+            std::mutex & lock1 = vertex_locks[edge.v1 % NUM_VERTEX_LOCKS];
+            std::mutex & lock2 = vertex_locks[edge.v2 % NUM_VERTEX_LOCKS];
+            if (&lock1 == &lock2) lock1.lock();
+            else std::lock(lock1, lock2);
+
+            if (stamps[edge_idx] != entry.stamp) {
+                /* Outdated entry - the edge has been updated in the meantime. */
+                lock1.unlock();
+                if (&lock1 != &lock2) lock2.unlock();
+                active -= 1;
+                continue;
+            }
 
-void LBPGraph::set_data_costs(int label, std::vector<SparseDataCost> const & costs) {
-    for (std::size_t i = 0; i < costs.size(); ++i) {
-        Vertex & vertex = vertices[costs[i].site];
-        vertex.labels.push_back(label);
-        int data_cost = costs[i].cost;
-        vertex.data_costs.push_back(data_cost);
+            std::copy(new_msgs.begin() + msg_offsets[edge_idx],
+                new_msgs.begin() + msg_offsets[edge_idx + 1],
+                old_msgs.begin() + msg_offsets[edge_idx]);
+            stamps[edge_idx] += 1;
+            if (&lock1 != &lock2) lock1.unlock();
+
+            /* Recompute the outgoing messages of v2 except the one back to v1. */
+            for (std::size_t n = incoming_offsets[edge.v2]; n < incoming_offsets[edge.v2 + 1]; ++n) {
+                std::size_t const out_edge_idx = incoming_edges[n] ^ 1;
+                if (edges[out_edge_idx].v2 == edge.v1) continue;
+
+                compute_message(out_edge_idx, potts_model, &partial_energies);
+                ENERGY_TYPE priority = residual(out_edge_idx);
+                unsigned int const stamp = ++stamps[out_edge_idx];
+                if (priority > 0)
+                    queue->push({priority, static_cast<int>(out_edge_idx), stamp}, &rng);
+            }
+            lock2.unlock();
 
-        if (data_cost < vertex.data_cost) {
-            vertex.label = label;
-            vertex.data_cost = data_cost;
+            updates += 1;
+            active -= 1;
         }
+    }
+}
 
-        for (int j : vertex.incoming_edges) {
-            DirectedEdge & incoming_edge = edges[j];
-            incoming_edge.old_msg.push_back(0);
-            incoming_edge.new_msg.push_back(0);
+ENERGY_TYPE LBPGraph::optimize(int num_iterations) {
+    if (!finalized) finalize();
+    if (!energy_valid) compute_energy();
+
+    if (schedule == RESIDUAL) {
+        if (queue == nullptr) init_residual_schedule();
+        /* An iteration corresponds to as many updates as there are edges. */
+        residual_updates(static_cast<std::size_t>(num_iterations) * edges.size());
+    } else {
+        flooding_iterations(num_iterations);
+    }
+
+    /* Select the labels and track the change of the energy. */
+    std::vector<int> previous_labels(vertex_labels);
+    double data_delta = 0.0;
+    #pragma omp parallel for reduction(+:data_delta)
+    for (std::size_t vertex_idx = 0; vertex_idx < vertex_labels.size(); ++vertex_idx) {
+        int const previous_data_cost = vertex_data_costs[vertex_idx];
+        ENERGY_TYPE min_energy = std::numeric_limits<ENERGY_TYPE>::max();
+        for (std::size_t j = label_offsets[vertex_idx]; j < label_offsets[vertex_idx + 1]; ++j) {
+            std::size_t const k = j - label_offsets[vertex_idx];
+            ENERGY_TYPE energy = data_costs[j];
+            for (std::size_t n = incoming_offsets[vertex_idx]; n < incoming_offsets[vertex_idx + 1]; ++n) {
+                energy += old_msgs[msg_offsets[incoming_edges[n]] + k];
+            }
+            if (energy < min_energy) {
+                min_energy = energy;
+                vertex_labels[vertex_idx] = labels[j];
+                vertex_data_costs[vertex_idx] = data_costs[j];
+            }
         }
+        data_delta += vertex_data_costs[vertex_idx] - previous_data_cost;
     }
-}
 
-int LBPGraph::what_label(int site) {
-    return vertices[site].label;
-}
+    double const smooth_delta = smooth_cost_func == potts
+        ? smooth_energy_change(previous_labels, PottsSmoothCost())
+        : smooth_energy_change(previous_labels, FunctionSmoothCost(smooth_cost_func));
 
-int LBPGraph::num_sites() {
-    return static_cast<int>(vertices.size());
+    current_energy += data_delta + smooth_delta;
+    return static_cast<ENERGY_TYPE>(current_energy);
 }
 
 MRF_NAMESPACE_END
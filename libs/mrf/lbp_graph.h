@@ -10,45 +10,65 @@
 #ifndef MRF_LBPGRAPH_HEADER
 #define MRF_LBPGRAPH_HEADER
 
-#include "graph.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "compressed_graph.h"
+#include "multi_queue.h"
+
+#define NUM_VERTEX_LOCKS 4096
 
 MRF_NAMESPACE_BEGIN
 
-/** Implementation of the loopy belief propagation algorithm. */
-class LBPGraph : public Graph {
-    private:
-        struct DirectedEdge {
-            int v1;
-            int v2;
-            std::vector<ENERGY_TYPE> new_msg;
-            std::vector<ENERGY_TYPE> old_msg;
-            DirectedEdge(int v1, int v2) : v1(v1), v2(v2) {}
+/**
+  * Implementation of the loopy belief propagation algorithm.
+  * Messages for the Potts model (mrf::potts) are computed in linear time.
+  *
+  * The graph is stored in the compressed layout of CompressedGraph, the
+  * messages in a contiguous array indexed by per edge offsets.
+  * The energy is only updated for relabeled vertices and their edges.
+  *
+  * With the residual schedule messages are updated asynchronously in the order
+  * of their change, converged regions of the graph are no longer updated.
+  */
+class LBPGraph : public CompressedGraph {
+    public:
+        enum Schedule {
+            /* All messages are updated synchronously in each iteration. */
+            FLOODING,
+            /* The messages with the largest change are updated first. */
+            RESIDUAL
         };
 
-        struct Vertex {
-            int label;
-            int data_cost;
-            std::vector<int> labels;
-            std::vector<int> data_costs;
-            std::vector<int> incoming_edges;
-            Vertex() : label(0), data_cost(MRF_MAX_ENERGYTERM) {}
-        };
+    private:
+        Schedule schedule;
 
+        /* The message of edge e (one entry per label of e.v2) starts at msg_offsets[e]. */
+        std::vector<std::size_t> msg_offsets;
+        std::vector<ENERGY_TYPE> old_msgs;
+        std::vector<ENERGY_TYPE> new_msgs;
+
+        /* Residual schedule: new_msgs holds the pending messages, stamps
+         * identify the latest queue entry of each edge. */
+        std::unique_ptr<MultiQueue> queue;
+        std::unique_ptr<std::mutex[]> vertex_locks;
+        std::vector<unsigned int> stamps;
+
+        void finalize(void);
+
+        void compute_message(std::size_t edge_idx, bool potts_model,
+            std::vector<ENERGY_TYPE> * partial_energies);
+        ENERGY_TYPE residual(std::size_t edge_idx) const;
+
+        void flooding_iterations(int num_iterations);
+        void init_residual_schedule(void);
+        void residual_updates(std::size_t num_updates);
 
-        std::vector<DirectedEdge> edges;
-        std::vector<Vertex> vertices;
-        SmoothCostFunction smooth_cost_func;
     public:
-        LBPGraph(int num_sites, int num_labels);
+        LBPGraph(int num_sites, int num_labels, Schedule schedule = FLOODING);
 
-        void set_smooth_cost(SmoothCostFunction func);
-        void set_data_costs(int label, std::vector<SparseDataCost> const & costs);
-        void set_neighbors(int site1, int site2);
-        ENERGY_TYPE compute_energy();
         ENERGY_TYPE optimize(int num_iterations);
-        int what_label(int site);
-
-        int num_sites();
 };
 
 MRF_NAMESPACE_END
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "maxflow.h"
+
+MRF_NAMESPACE_BEGIN
+
+MaxFlow::MaxFlow(void) : num_nodes(0), max_active_label(-1), max_label(-1) {}
+
+void MaxFlow::reset(int num_nodes) {
+    this->num_nodes = num_nodes;
+    source_caps.assign(num_nodes, 0);
+    sink_caps.assign(num_nodes, 0);
+    edges.clear();
+}
+
+void MaxFlow::add_tweights(int node, CapType cap_source, CapType cap_sink) {
+    assert(0 <= node && node < num_nodes);
+    source_caps[node] += cap_source;
+    sink_caps[node] += cap_sink;
+}
+
+void MaxFlow::add_edge(int node1, int node2, CapType cap, CapType rev_cap) {
+    assert(0 <= node1 && node1 < num_nodes && 0 <= node2 && node2 < num_nodes);
+    assert(cap >= 0 && rev_cap >= 0);
+    edges.push_back({node1, node2, cap, rev_cap});
+}
+
+void MaxFlow::add_term2(int node1, int node2, CapType a, CapType b, CapType c, CapType d) {
+    /* E(x1, x2) = A + (C - A) x1 + (D - C) x2 + (B + C - A - D) (1 - x1) x2,
+     * the last term is paid if node1 stays with the source and node2 is cut off. */
+    CapType const cap = b + c - a - d;
+    assert(cap >= 0);
+    add_term1(node1, 0, c - a);
+    add_term1(node2, 0, d - c);
+    add_edge(node1, node2, cap, 0);
+}
+
+/**
+  * Creates the arcs in CSR layout and saturates the arcs from the source.
+  * Only the difference of the terminal capacities of a node has to be routed,
+  * the common part is added to flow.
+  */
+void MaxFlow::build_residual_graph(CapType * flow) {
+    int const sink = num_nodes;
+
+    *flow = 0;
+    excesses.assign(num_nodes + 1, 0);
+    first_arcs.assign(num_nodes + 2, 0);
+    for (int node = 0; node < num_nodes; ++node) {
+        CapType const common = std::min(source_caps[node], sink_caps[node]);
+        *flow += common;
+        excesses[node] = source_caps[node] - common;
+        if (sink_caps[node] == common) continue;
+        first_arcs[node + 1] += 1;
+        first_arcs[sink + 1] += 1;
+    }
+    for (Edge const & edge : edges) {
+        first_arcs[edge.node1 + 1] += 1;
+        first_arcs[edge.node2 + 1] += 1;
+    }
+    for (int node = 0; node <= sink; ++node) {
+        first_arcs[node + 1] += first_arcs[node];
+    }
+
+    std::size_t const num_arcs = first_arcs.back();
+    heads.resize(num_arcs);
+    reverse_arcs.resize(num_arcs);
+    residuals.resize(num_arcs);
+    current_arcs.assign(first_arcs.begin(), first_arcs.end() - 1);
+
+    auto add_arcs = [this] (int node1, int node2, CapType cap, CapType rev_cap) {
+        int const arc = current_arcs[node1]++;
+        int const rev_arc = current_arcs[node2]++;
+        heads[arc] = node2;
+        heads[rev_arc] = node1;
+        residuals[arc] = cap;
+        residuals[rev_arc] = rev_cap;
+        reverse_arcs[arc] = rev_arc;
+        reverse_arcs[rev_arc] = arc;
+    };
+
+    for (int node = 0; node < num_nodes; ++node) {
+        CapType const common = std::min(source_caps[node], sink_caps[node]);
+        if (sink_caps[node] == common) continue;
+        add_arcs(node, sink, sink_caps[node] - common, 0);
+    }
+    for (Edge const & edge : edges) {
+        add_arcs(edge.node1, edge.node2, edge.cap, edge.rev_cap);
+    }
+}
+
+void MaxFlow::activate(int node) {
+    int const label = labels[node];
+    next_active[node] = bucket_heads[label];
+    bucket_heads[label] = node;
+    max_active_label = std::max(max_active_label, label);
+}
+
+void MaxFlow::add_to_label(int node) {
+    int const label = labels[node];
+    prev_in_label[node] = -1;
+    next_in_label[node] = label_heads[label];
+    if (label_heads[label] >= 0) prev_in_label[label_heads[label]] = node;
+    label_heads[label] = node;
+    max_label = std::max(max_label, label);
+}
+
+void MaxFlow::remove_from_label(int node) {
+    int const prev = prev_in_label[node];
+    int const next = next_in_label[node];
+    if (prev >= 0) next_in_label[prev] = next;
+    else label_heads[labels[node]] = next;
+    if (next >= 0) prev_in_label[next] = prev;
+}
+
+/**
+  * Sets the label of the node to one above its lowest neighbor in the residual
+  * graph. If the node was the last one with its label, all nodes with higher
+  * labels are cut off from the sink.
+  */
+void MaxFlow::relabel(int node) {
+    int const unreachable = num_nodes + 1;
+    int const old_label = labels[node];
+
+    remove_from_label(node);
+    if (label_heads[old_label] < 0) {
+        for (int label = old_label + 1; label <= max_label; ++label) {
+            for (int n = label_heads[label]; n >= 0; n = next_in_label[n]) {
+                labels[n] = unreachable;
+            }
+            label_heads[label] = -1;
+        }
+        labels[node] = unreachable;
+        max_label = old_label - 1;
+        return;
+    }
+
+    int label = unreachable;
+    for (int arc = first_arcs[node]; arc < first_arcs[node + 1]; ++arc) {
+        if (residuals[arc] > 0) label = std::min(label, labels[heads[arc]] + 1);
+    }
+    labels[node] = label;
+    if (label != unreachable) add_to_label(node);
+}
+
+/**
+  * Sets the labels to the distances to the sink in the residual graph (breadth
+  * first search along reversed arcs) and collects the active nodes.
+  */
+void MaxFlow::global_relabel(void) {
+    int const sink = num_nodes;
+    int const unreachable = num_nodes + 1;
+
+    labels.assign(num_nodes + 1, unreachable);
+    labels[sink] = 0;
+    queue.assign(1, sink);
+    for (std::size_t i = 0; i < queue.size(); ++i) {
+        int const node = queue[i];
+        for (int arc = first_arcs[node]; arc < first_arcs[node + 1]; ++arc) {
+            int const tail = heads[arc];
+            if (labels[tail] != unreachable || residuals[reverse_arcs[arc]] <= 0) continue;
+            labels[tail] = labels[node] + 1;
+            queue.push_back(tail);
+        }
+    }
+
+    bucket_heads.assign(num_nodes + 1, -1);
+    next_active.resize(num_nodes + 1);
+    max_active_label = -1;
+    label_heads.assign(num_nodes + 1, -1);
+    prev_in_label.resize(num_nodes + 1);
+    next_in_label.resize(num_nodes + 1);
+    max_label = -1;
+    for (int node = 0; node < num_nodes; ++node) {
+        current_arcs[node] = first_arcs[node];
+        if (labels[node] == unreachable) continue;
+        add_to_label(node);
+        if (excesses[node] > 0) activate(node);
+    }
+}
+
+/**
+  * Pushes the excess of the node along admissible arcs (towards nodes with
+  * the next lower label) and relabels the node whenever none is left, until
+  * the excess is gone or the sink became unreachable.
+  * Returns the number of relabel operations.
+  */
+int MaxFlow::discharge(int node) {
+    int const sink = num_nodes;
+    int const unreachable = num_nodes + 1;
+
+    int num_relabels = 0;
+    while (true) {
+        int const end = first_arcs[node + 1];
+        int & arc = current_arcs[node];
+        for (; arc < end; ++arc) {
+            int const head = heads[arc];
+            if (residuals[arc] <= 0 || labels[head] != labels[node] - 1) continue;
+
+            CapType const amount = std::min(excesses[node], residuals[arc]);
+            residuals[arc] -= amount;
+            residuals[reverse_arcs[arc]] += amount;
+            excesses[node] -= amount;
+            if (excesses[head] <= 0 && head != sink) activate(head);
+            excesses[head] += amount;
+
+            /* The arc stays current - it may have residual capacity left. */
+            if (excesses[node] <= 0) return num_relabels;
+        }
+
+        relabel(node);
+        arc = first_arcs[node];
+        num_relabels += 1;
+
+        if (labels[node] == unreachable) return num_relabels;
+    }
+}
+
+/** Marks all nodes from which the sink is reachable in the residual graph. */
+void MaxFlow::compute_sink_segment(void) {
+    int const sink = num_nodes;
+
+    sink_segment.assign(num_nodes + 1, false);
+    sink_segment[sink] = true;
+    queue.assign(1, sink);
+    for (std::size_t i = 0; i < queue.size(); ++i) {
+        int const node = queue[i];
+        for (int arc = first_arcs[node]; arc < first_arcs[node + 1]; ++arc) {
+            int const tail = heads[arc];
+            if (sink_segment[tail] || residuals[reverse_arcs[arc]] <= 0) continue;
+            sink_segment[tail] = true;
+            queue.push_back(tail);
+        }
+    }
+}
+
+MaxFlow::CapType MaxFlow::maxflow(void) {
+    CapType flow;
+    build_residual_graph(&flow);
+    global_relabel();
+
+    /* Labels drift from the distances with each relabel operation - recompute
+     * them once the relabel work amounts to a few breadth first searches. */
+    int num_relabels = 0;
+    while (max_active_label >= 0) {
+        int const node = bucket_heads[max_active_label];
+        if (node < 0) {
+            max_active_label -= 1;
+            continue;
+        }
+        bucket_heads[max_active_label] = next_active[node];
+        /* Cut off from the sink by a gap in the meantime. */
+        if (labels[node] != max_active_label) continue;
+
+        num_relabels += discharge(node);
+        if (num_relabels > 30 * num_nodes) {
+            global_relabel();
+            num_relabels = 0;
+        }
+    }
+
+    compute_sink_segment();
+    return flow + excesses[num_nodes];
+}
+
+MRF_NAMESPACE_END
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef MRF_MAXFLOW_HEADER
+#define MRF_MAXFLOW_HEADER
+
+#include <vector>
+
+#include "graph.h"
+
+MRF_NAMESPACE_BEGIN
+
+/**
+  * Minimum s-t cut of binary energies with the push-relabel algorithm
+  * (Goldberg and Tarjan, "A New Approach to the Maximum-Flow Problem",
+  * JACM 1988): active nodes with the highest label are discharged first, the
+  * labels are periodically reset to the exact distances to the sink and nodes
+  * above a label without any node are known to be cut off from the sink (gap).
+  * Only the maximum preflow is computed, which suffices for the minimum cut.
+  *
+  * Edges and terminal capacities are collected first, the residual graph is
+  * built in compressed (CSR) layout on the call of maxflow. Nodes in the sink
+  * segment of the minimum cut correspond to variables with the value 1, nodes
+  * which are not separated from the source by the cut keep the value 0.
+  */
+class MaxFlow {
+    public:
+        typedef double CapType;
+
+    private:
+        struct Edge {
+            int node1;
+            int node2;
+            CapType cap;
+            CapType rev_cap;
+        };
+
+        int num_nodes;
+        std::vector<CapType> source_caps;
+        std::vector<CapType> sink_caps;
+        std::vector<Edge> edges;
+
+        /* Residual graph over the nodes and the sink (num_nodes) - the arcs
+         * from the source are saturated right away and thus not represented.
+         * The arcs of node v are [first_arcs[v], first_arcs[v + 1]). */
+        std::vector<int> first_arcs;
+        std::vector<int> heads;
+        std::vector<int> reverse_arcs;
+        std::vector<CapType> residuals;
+
+        /* Excess, label (a lower bound of the distance to the sink, num_nodes + 1
+         * if the sink is unreachable) and next arc to be tried of each node. */
+        std::vector<CapType> excesses;
+        std::vector<int> labels;
+        std::vector<int> current_arcs;
+
+        /* Active nodes as linked lists per label. */
+        std::vector<int> bucket_heads;
+        std::vector<int> next_active;
+        int max_active_label;
+
+        /* All nodes which may reach the sink as doubly linked lists per label. */
+        std::vector<int> label_heads;
+        std::vector<int> prev_in_label;
+        std::vector<int> next_in_label;
+        int max_label;
+
+        std::vector<int> queue;
+        std::vector<bool> sink_segment;
+
+        void build_residual_graph(CapType * flow);
+        void activate(int node);
+        void add_to_label(int node);
+        void remove_from_label(int node);
+        void relabel(int node);
+        void global_relabel(void);
+        int discharge(int node);
+        void compute_sink_segment(void);
+
+    public:
+        MaxFlow(void);
+
+        /** Removes all nodes and edges and adds num_nodes unconnected nodes. */
+        void reset(int num_nodes);
+
+        /** Adds capacities of the edges from the source and to the sink of node. */
+        void add_tweights(int node, CapType cap_source, CapType cap_sink);
+        /** Adds the edge node1 -> node2 with cap and node2 -> node1 with rev_cap. */
+        void add_edge(int node1, int node2, CapType cap, CapType rev_cap);
+
+        /**
+          * Adds the unary term of a binary variable (E0: value 0, E1: value 1).
+          */
+        void add_term1(int node, CapType e0, CapType e1);
+        /**
+          * Adds the pairwise term E(x1, x2) with A = E(0,0), B = E(0,1),
+          * C = E(1,0) and D = E(1,1), which has to be regular (B + C >= A + D).
+          */
+        void add_term2(int node1, int node2, CapType a, CapType b, CapType c, CapType d);
+
+        /** Computes the maximum flow (the energy up to a constant) and the minimum cut. */
+        CapType maxflow(void);
+
+        /** Returns true if node is in the sink segment of the minimum cut. */
+        bool in_sink_segment(int node) const;
+};
+
+inline void
+MaxFlow::add_term1(int node, CapType e0, CapType e1) {
+    /* Value 1 (sink segment) cuts the edge from the source and vice versa. */
+    add_tweights(node, e1, e0);
+}
+
+inline bool
+MaxFlow::in_sink_segment(int node) const {
+    return sink_segment[node];
+}
+
+MRF_NAMESPACE_END
+
+#endif /* MRF_MAXFLOW_HEADER */
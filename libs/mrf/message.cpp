@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "message.h"
+
+MRF_NAMESPACE_BEGIN
+
+void potts_message(int const * labels1, std::size_t num_labels1,
+    ENERGY_TYPE const * partial_energies,
+    int const * labels2, std::size_t num_labels2, ENERGY_TYPE weight, ENERGY_TYPE * msg) {
+
+    ENERGY_TYPE min_energy = std::numeric_limits<ENERGY_TYPE>::max();
+    for (std::size_t k = 0; k < num_labels1; ++k)
+        min_energy = std::min(min_energy, partial_energies[k]);
+    ENERGY_TYPE const label_change = min_energy + weight * MRF_MAX_ENERGYTERM;
+
+    std::size_t k = 0;
+    for (std::size_t j = 0; j < num_labels2; ++j) {
+        int label2 = labels2[j];
+        while (k < num_labels1 && labels1[k] < label2) ++k;
+
+        ENERGY_TYPE energy = label_change;
+        if (label2 != 0 && k < num_labels1 && labels1[k] == label2)
+            energy = std::min(energy, partial_energies[k]);
+        msg[j] = energy;
+    }
+}
+
+void normalize_message(ENERGY_TYPE * begin, ENERGY_TYPE * end) {
+    ENERGY_TYPE min_msg = std::numeric_limits<ENERGY_TYPE>::max();
+    for (ENERGY_TYPE * msg = begin; msg != end; ++msg)
+       min_msg = std::min(min_msg, *msg);
+    for (ENERGY_TYPE * msg = begin; msg != end; ++msg)
+       *msg -= min_msg;
+}
+
+MRF_NAMESPACE_END
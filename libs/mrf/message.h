@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef MRF_MESSAGE_HEADER
+#define MRF_MESSAGE_HEADER
+
+#include <cstddef>
+#include <limits>
+
+#include "graph.h"
+
+MRF_NAMESPACE_BEGIN
+
+/**
+  * Min-sum message from site1 to site2 for sparse label sets (weight of the edge w):
+  * msg[j] = min_k w * smooth_cost(site1, site2, labels1[k], labels2[j]) + partial_energies[k]
+  */
+template <typename SmoothCost>
+void generic_message(int site1, int site2, SmoothCost const & smooth_cost,
+    int const * labels1, std::size_t num_labels1, ENERGY_TYPE const * partial_energies,
+    int const * labels2, std::size_t num_labels2, ENERGY_TYPE weight, ENERGY_TYPE * msg);
+
+/**
+  * Min-sum message for the Potts model in O(L1 + L2) instead of O(L1 * L2):
+  * a label of site2 is either reached from the best label of site1 at the cost
+  * weight * MRF_MAX_ENERGYTERM or from the same label of site1 at no cost.
+  * Relies on the labels of both sites being sorted.
+  */
+void potts_message(int const * labels1, std::size_t num_labels1,
+    ENERGY_TYPE const * partial_energies,
+    int const * labels2, std::size_t num_labels2, ENERGY_TYPE weight, ENERGY_TYPE * msg);
+
+/** Subtracts the minimum from all entries of the message. */
+void normalize_message(ENERGY_TYPE * begin, ENERGY_TYPE * end);
+
+template <typename SmoothCost> void
+generic_message(int site1, int site2, SmoothCost const & smooth_cost,
+    int const * labels1, std::size_t num_labels1, ENERGY_TYPE const * partial_energies,
+    int const * labels2, std::size_t num_labels2, ENERGY_TYPE weight, ENERGY_TYPE * msg) {
+
+    for (std::size_t j = 0; j < num_labels2; ++j) {
+        int label2 = labels2[j];
+        ENERGY_TYPE min_energy = std::numeric_limits<ENERGY_TYPE>::max();
+        for (std::size_t k = 0; k < num_labels1; ++k) {
+            int label1 = labels1[k];
+            ENERGY_TYPE energy = weight * smooth_cost(site1, site2, label1, label2)
+                + partial_energies[k];
+            if (energy < min_energy)
+                min_energy = energy;
+        }
+        msg[j] = min_energy;
+    }
+}
+
+MRF_NAMESPACE_END
+
+#endif /* MRF_MESSAGE_HEADER */
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+
+#include "multi_queue.h"
+
+MRF_NAMESPACE_BEGIN
+
+namespace {
+    bool lower_priority(MultiQueue::Entry const & entry1, MultiQueue::Entry const & entry2) {
+        return entry1.priority < entry2.priority;
+    }
+}
+
+MultiQueue::MultiQueue(std::size_t num_queues) :
+    queues(new Queue[std::max<std::size_t>(num_queues, 2)]),
+    num_queues(std::max<std::size_t>(num_queues, 2)), num_entries(0) {}
+
+void MultiQueue::push(Entry const & entry, std::minstd_rand * rng) {
+    Queue & queue = queues[(*rng)() % num_queues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.heap.push_back(entry);
+    std::push_heap(queue.heap.begin(), queue.heap.end(), lower_priority);
+    num_entries += 1;
+}
+
+bool MultiQueue::top(std::size_t queue_idx, ENERGY_TYPE * priority) {
+    Queue & queue = queues[queue_idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.heap.empty()) return false;
+    *priority = queue.heap.front().priority;
+    return true;
+}
+
+bool MultiQueue::pop(std::size_t queue_idx, Entry * entry) {
+    Queue & queue = queues[queue_idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.heap.empty()) return false;
+    std::pop_heap(queue.heap.begin(), queue.heap.end(), lower_priority);
+    *entry = queue.heap.back();
+    queue.heap.pop_back();
+    num_entries -= 1;
+    return true;
+}
+
+bool MultiQueue::pop(Entry * entry, std::minstd_rand * rng) {
+    while (num_entries > 0) {
+        std::size_t queue1 = (*rng)() % num_queues;
+        std::size_t queue2 = (*rng)() % num_queues;
+        ENERGY_TYPE priority1, priority2;
+        bool valid1 = top(queue1, &priority1);
+        bool valid2 = top(queue2, &priority2);
+
+        if (valid1 && (!valid2 || priority1 >= priority2)) {
+            if (pop(queue1, entry)) return true;
+        } else if (valid2) {
+            if (pop(queue2, entry)) return true;
+        } else {
+            /* Both heaps empty - the remaining entries may be in any other heap. */
+            for (std::size_t i = 0; i < num_queues; ++i) {
+                if (pop((queue1 + i) % num_queues, entry)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool MultiQueue::empty(void) {
+    for (std::size_t i = 0; i < num_queues; ++i) {
+        Queue & queue = queues[i];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.heap.empty()) return false;
+    }
+    return true;
+}
+
+MRF_NAMESPACE_END
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef MRF_MULTIQUEUE_HEADER
+#define MRF_MULTIQUEUE_HEADER
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "graph.h"
+
+MRF_NAMESPACE_BEGIN
+
+/**
+  * Relaxed concurrent max priority queue (Rihani, Sanders and Dementiev,
+  * "MultiQueues: Simple Relaxed Concurrent Priority Queues", SPAA 2015).
+  * Entries are pushed into a random binary heap, pop takes the better top
+  * of two random heaps. Each heap has its own lock, popped entries are
+  * therefore only approximately the ones with the highest priority.
+  *
+  * Entries are never updated in place - outdated entries have to be
+  * detected by the caller (e.g. with the stamp).
+  */
+class MultiQueue {
+    public:
+        struct Entry {
+            ENERGY_TYPE priority;
+            int item;
+            unsigned int stamp;
+        };
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::vector<Entry> heap;
+        };
+
+        std::unique_ptr<Queue[]> queues;
+        std::size_t num_queues;
+        std::atomic<std::size_t> num_entries;
+
+        bool top(std::size_t queue_idx, ENERGY_TYPE * priority);
+        bool pop(std::size_t queue_idx, Entry * entry);
+
+    public:
+        MultiQueue(std::size_t num_queues);
+
+        void push(Entry const & entry, std::minstd_rand * rng);
+        /** Returns false if all heaps were found empty. */
+        bool pop(Entry * entry, std::minstd_rand * rng);
+        /** Checks every heap under its lock, unlike size. */
+        bool empty(void);
+
+        std::size_t size(void) const;
+};
+
+inline std::size_t
+MultiQueue::size(void) const {
+    return num_entries;
+}
+
+MRF_NAMESPACE_END
+
+#endif /* MRF_MULTIQUEUE_HEADER */
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "trws_graph.h"
+#include "message.h"
+
+MRF_NAMESPACE_BEGIN
+
+/**
+  * Smoothness term of an edge in both directions - the term of the energy the
+  * messages and the label selection are based on.
+  */
+template <typename SmoothCost>
+struct EdgeSmoothCost {
+    SmoothCost const & smooth_cost;
+    ENERGY_TYPE operator()(int s1, int s2, int l1, int l2) const {
+        return smooth_cost(s1, s2, l1, l2) + smooth_cost(s2, s1, l2, l1);
+    }
+};
+
+TRWSGraph::TRWSGraph(int num_sites, int) : CompressedGraph(num_sites) {}
+
+void TRWSGraph::finalize(void) {
+    build_layout();
+
+    std::size_t const num_vertices = vertex_labels.size();
+
+    /* Each vertex belongs to max(#preceding, #succeeding neighbors) monotonic chains. */
+    gammas.resize(num_vertices);
+    for (std::size_t v = 0; v < num_vertices; ++v) {
+        std::size_t num_before = 0;
+        std::size_t num_after = 0;
+        for (std::size_t n = incoming_offsets[v]; n < incoming_offsets[v + 1]; ++n) {
+            if (static_cast<std::size_t>(edges[incoming_edges[n]].v1) < v) num_before += 1;
+            else num_after += 1;
+        }
+        gammas[v] = ENERGY_TYPE(1) / std::max<std::size_t>(std::max(num_before, num_after), 1);
+    }
+
+    /* Messages - sized once for all edges. */
+    init_message_offsets(&msg_offsets);
+    msgs.assign(msg_offsets.back(), 0);
+
+    if (labels_set) init_certain_messages(msg_offsets, &msgs, true);
+
+    finalized = true;
+}
+
+/**
+  * Selects the label given the labels of the preceding neighbors and the
+  * messages of the succeeding neighbors and updates the energy.
+  */
+template <typename SmoothCost> void
+TRWSGraph::select_label(int vertex, SmoothCost const & smooth_cost) {
+    int const label = vertex_labels[vertex];
+    int const data_cost = vertex_data_costs[vertex];
+    EdgeSmoothCost<SmoothCost> const edge_smooth_cost = {smooth_cost};
+
+    ENERGY_TYPE min_energy = std::numeric_limits<ENERGY_TYPE>::max();
+    for (std::size_t j = label_offsets[vertex]; j < label_offsets[vertex + 1]; ++j) {
+        std::size_t const k = j - label_offsets[vertex];
+        ENERGY_TYPE energy = data_costs[j];
+        for (std::size_t n = incoming_offsets[vertex]; n < incoming_offsets[vertex + 1]; ++n) {
+            int const edge_idx = incoming_edges[n];
+            int const neighbor = edges[edge_idx].v1;
+            /* Same edge term as within the messages: from the neighbor to the vertex. */
+            if (neighbor < vertex) {
+                energy += edge_weight(edge_idx)
+                    * edge_smooth_cost(neighbor, vertex, vertex_labels[neighbor], labels[j]);
+            } else {
+                energy += msgs[msg_offsets[edge_idx] + k];
+            }
+        }
+        if (energy < min_energy) {
+            min_energy = energy;
+            vertex_labels[vertex] = labels[j];
+            vertex_data_costs[vertex] = data_costs[j];
+        }
+    }
+
+    int const new_label = vertex_labels[vertex];
+    if (new_label == label) return;
+
+    double delta = vertex_data_costs[vertex] - data_cost;
+    for (std::size_t n = incoming_offsets[vertex]; n < incoming_offsets[vertex + 1]; ++n) {
+        int const edge_idx = incoming_edges[n];
+        int const neighbor = edges[edge_idx].v1;
+        int const neighbor_label = vertex_labels[neighbor];
+        delta += edge_weight(edge_idx) * (edge_smooth_cost(neighbor, vertex, neighbor_label, new_label)
+            - edge_smooth_cost(neighbor, vertex, neighbor_label, label));
+    }
+    current_energy += delta;
+}
+
+/** Updates the messages to the succeeding (forward) or preceding neighbors. */
+template <typename SmoothCost> void
+TRWSGraph::update_messages(int vertex, bool forward, SmoothCost const & smooth_cost,
+    std::vector<ENERGY_TYPE> * theta, std::vector<ENERGY_TYPE> * partial_energies) {
+
+    std::size_t const num_labels1 = num_labels(vertex);
+    if (num_labels1 == 0) return;
+
+    /* Data costs plus all incoming messages. */
+    DATA_COST_TYPE const * costs = data_costs.data() + label_offsets[vertex];
+    theta->assign(costs, costs + num_labels1);
+    for (std::size_t n = incoming_offsets[vertex]; n < incoming_offsets[vertex + 1]; ++n) {
+        ENERGY_TYPE const * msg = msgs.data() + msg_offsets[incoming_edges[n]];
+        for (std::size_t k = 0; k < num_labels1; ++k)
+            (*theta)[k] += msg[k];
+    }
+
+    if (forward) select_label(vertex, smooth_cost);
+
+    int const * labels1 = labels.data() + label_offsets[vertex];
+    ENERGY_TYPE const gamma = gammas[vertex];
+    partial_energies->resize(num_labels1);
+    for (std::size_t n = incoming_offsets[vertex]; n < incoming_offsets[vertex + 1]; ++n) {
+        int const in_edge_idx = incoming_edges[n];
+        int const neighbor = edges[in_edge_idx].v1;
+        if (forward ? neighbor < vertex : neighbor > vertex) continue;
+
+        ENERGY_TYPE const * in_msg = msgs.data() + msg_offsets[in_edge_idx];
+        for (std::size_t k = 0; k < num_labels1; ++k)
+            (*partial_energies)[k] = gamma * (*theta)[k] - in_msg[k];
+
+        int const out_edge_idx = in_edge_idx ^ 1;
+        int const * labels2 = labels.data() + label_offsets[neighbor];
+        std::size_t const num_labels2 = num_labels(neighbor);
+        ENERGY_TYPE const weight = edge_weight(out_edge_idx);
+        ENERGY_TYPE * out_msg = msgs.data() + msg_offsets[out_edge_idx];
+        /* The Potts model is symmetric - both directions double the weight. */
+        if (std::is_same<SmoothCost, PottsSmoothCost>::value) {
+            potts_message(labels1, num_labels1, partial_energies->data(),
+                labels2, num_labels2, 2 * weight, out_msg);
+        } else {
+            generic_message(vertex, neighbor, EdgeSmoothCost<SmoothCost>{smooth_cost},
+                labels1, num_labels1, partial_energies->data(),
+                labels2, num_labels2, weight, out_msg);
+        }
+        normalize_message(out_msg, out_msg + num_labels2);
+    }
+}
+
+ENERGY_TYPE TRWSGraph::optimize(int num_iterations) {
+    if (!finalized) finalize();
+    if (!energy_valid) compute_energy();
+
+    if (smooth_cost_func == potts) {
+        iterate(num_iterations, PottsSmoothCost());
+    } else {
+        iterate(num_iterations, FunctionSmoothCost(smooth_cost_func));
+    }
+
+    return static_cast<ENERGY_TYPE>(current_energy);
+}
+
+ENERGY_TYPE TRWSGraph::lower_bound(void) {
+    if (!finalized) finalize();
+
+    double const bound = smooth_cost_func == potts
+        ? lower_bound(PottsSmoothCost())
+        : lower_bound(FunctionSmoothCost(smooth_cost_func));
+    return static_cast<ENERGY_TYPE>(bound);
+}
+
+/**
+  * The energy reparametrized by the messages (unary terms: data costs plus all
+  * incoming messages, pairwise terms: edge term minus the messages in both
+  * directions) equals the energy for any labeling. It is split into the
+  * monotonic chains the gammas are based on: the k-th edge from a preceding
+  * neighbor continues with the k-th edge to a succeeding neighbor, each chain
+  * receives gamma times the unary term of its vertices. The sum of the minima
+  * of the chains, computed by dynamic programming, is thus a lower bound.
+  */
+template <typename SmoothCost> double
+TRWSGraph::lower_bound(SmoothCost const & smooth_cost) const {
+    EdgeSmoothCost<SmoothCost> const edge_smooth_cost = {smooth_cost};
+    int const num_vertices = static_cast<int>(vertex_labels.size());
+
+    /* Minimal energy of the chain which continues from v2 to v1 of edge e (v1 > v2),
+     * per label of v2 - stored like the message of e. */
+    std::vector<double> chain_energies(msg_offsets.back());
+    std::vector<double> theta;
+    std::vector<double> chain_energy;
+
+    double bound = 0.0;
+    for (int vertex = 0; vertex < num_vertices; ++vertex) {
+        std::size_t const num_labels1 = num_labels(vertex);
+        if (num_labels1 == 0) continue;
+
+        theta.assign(data_costs.begin() + label_offsets[vertex],
+            data_costs.begin() + label_offsets[vertex + 1]);
+        std::vector<int> in_edges;
+        std::vector<int> out_edges;
+        for (std::size_t n = incoming_offsets[vertex]; n < incoming_offsets[vertex + 1]; ++n) {
+            int const edge_idx = incoming_edges[n];
+            ENERGY_TYPE const * msg = msgs.data() + msg_offsets[edge_idx];
+            for (std::size_t k = 0; k < num_labels1; ++k)
+                theta[k] += msg[k];
+
+            if (num_labels(edges[edge_idx].v1) == 0) continue;
+            if (edges[edge_idx].v1 < vertex) in_edges.push_back(edge_idx);
+            else out_edges.push_back(edge_idx);
+        }
+
+        ENERGY_TYPE const gamma = gammas[vertex];
+        int const * labels1 = labels.data() + label_offsets[vertex];
+        std::size_t const num_chains = std::max<std::size_t>(
+            std::max(in_edges.size(), out_edges.size()), 1);
+        for (std::size_t i = 0; i < num_chains; ++i) {
+            chain_energy.assign(num_labels1, 0.0);
+            if (i < in_edges.size()) {
+                int const edge_idx = in_edges[i];
+                int const neighbor = edges[edge_idx].v1;
+                int const * labels2 = labels.data() + label_offsets[neighbor];
+                std::size_t const num_labels2 = num_labels(neighbor);
+                double const * prev_energy = chain_energies.data() + msg_offsets[edge_idx ^ 1];
+                ENERGY_TYPE const * msg_to_vertex = msgs.data() + msg_offsets[edge_idx];
+                ENERGY_TYPE const * msg_to_neighbor = msgs.data() + msg_offsets[edge_idx ^ 1];
+                ENERGY_TYPE const weight = edge_weight(edge_idx);
+                for (std::size_t k = 0; k < num_labels1; ++k) {
+                    double min_energy = std::numeric_limits<double>::max();
+                    for (std::size_t l = 0; l < num_labels2; ++l) {
+                        double const energy = prev_energy[l] - msg_to_neighbor[l]
+                            + weight * edge_smooth_cost(neighbor, vertex, labels2[l], labels1[k]);
+                        min_energy = std::min(min_energy, energy);
+                    }
+                    chain_energy[k] = min_energy - msg_to_vertex[k];
+                }
+            }
+            for (std::size_t k = 0; k < num_labels1; ++k)
+                chain_energy[k] += gamma * theta[k];
+
+            if (i < out_edges.size()) {
+                std::copy(chain_energy.begin(), chain_energy.end(),
+                    chain_energies.begin() + msg_offsets[out_edges[i]]);
+            } else {
+                bound += *std::min_element(chain_energy.begin(), chain_energy.end());
+            }
+        }
+    }
+
+    return bound;
+}
+
+template <typename SmoothCost> void
+TRWSGraph::iterate(int num_iterations, SmoothCost const & smooth_cost) {
+    int const num_vertices = static_cast<int>(vertex_labels.size());
+
+    std::vector<ENERGY_TYPE> theta;
+    std::vector<ENERGY_TYPE> partial_energies;
+    for (int i = 0; i < num_iterations; ++i) {
+        for (int vertex = 0; vertex < num_vertices; ++vertex)
+            update_messages(vertex, true, smooth_cost, &theta, &partial_energies);
+        for (int vertex = num_vertices - 1; vertex >= 0; --vertex)
+            update_messages(vertex, false, smooth_cost, &theta, &partial_energies);
+    }
+}
+
+MRF_NAMESPACE_END
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef MRF_TRWSGRAPH_HEADER
+#define MRF_TRWSGRAPH_HEADER
+
+#include <cstddef>
+
+#include "compressed_graph.h"
+
+MRF_NAMESPACE_BEGIN
+
+/**
+  * Implementation of sequential tree-reweighted message passing (Kolmogorov,
+  * "Convergent Tree-Reweighted Message Passing for Energy Minimization",
+  * PAMI 2006). Sites are processed in the order of their index, each
+  * iteration consists of a forward and a backward pass, the labels are
+  * selected during the forward pass. Messages and labels are based on the
+  * smoothness term of each edge in both directions, like the energy.
+  *
+  * The graph is stored in the compressed layout of CompressedGraph. Messages
+  * are updated in place, i.e. only one message per directed edge is stored.
+  */
+class TRWSGraph : public CompressedGraph {
+    private:
+        /* The message of edge e (one entry per label of e.v2) starts at msg_offsets[e]. */
+        std::vector<std::size_t> msg_offsets;
+        std::vector<ENERGY_TYPE> msgs;
+
+        /* Weight of the data costs within the messages of each vertex. */
+        std::vector<ENERGY_TYPE> gammas;
+
+        void finalize(void);
+
+        template <typename SmoothCost>
+        void iterate(int num_iterations, SmoothCost const & smooth_cost);
+        template <typename SmoothCost>
+        void select_label(int vertex, SmoothCost const & smooth_cost);
+        template <typename SmoothCost>
+        void update_messages(int vertex, bool forward, SmoothCost const & smooth_cost,
+            std::vector<ENERGY_TYPE> * theta, std::vector<ENERGY_TYPE> * partial_energies);
+        template <typename SmoothCost>
+        double lower_bound(SmoothCost const & smooth_cost) const;
+
+    public:
+        TRWSGraph(int num_sites, int num_labels);
+
+        ENERGY_TYPE optimize(int num_iterations);
+
+        /**
+          * Returns a lower bound of the energy of any labeling: the sum of the
+          * minima of the unary and pairwise terms reparametrized by the current
+          * messages. Takes O(L1 * L2) per edge and is meant for diagnostics.
+          */
+        ENERGY_TYPE lower_bound(void);
+};
+
+MRF_NAMESPACE_END
+
+#endif /* MRF_TRWSGRAPH_HEADER */
@@ -154,12 +154,21 @@ calculate_face_projection_infos(mve::TriangleMesh::ConstPtr mesh,
             view_counter.progress<SIMPLE>();
 
             TextureView * texture_view = &texture_views->at(j);
-            texture_view->load_image();
-            texture_view->generate_validity_mask();
+            if (!texture_view->load_cache(settings.data_term == GMI)) {
+                texture_view->load_image();
+                texture_view->generate_validity_mask();
 
-            if (settings.data_term == GMI) {
-                texture_view->generate_gradient_magnitude();
-                texture_view->erode_validity_mask();
+                if (settings.data_term == GMI) {
+                    texture_view->generate_gradient_magnitude();
+                    texture_view->erode_validity_mask();
+                }
+
+                try {
+                    texture_view->save_cache();
+                } catch (util::FileException & e) {
+                    #pragma omp critical
+                    std::cerr << "\tCould not write view cache: " << e.what() << std::endl;
+                }
             }
 
             math::Vec3f const & view_pos = texture_view->get_pos();
@@ -293,7 +302,7 @@ postprocess_face_infos(Settings const & settings,
 
             /* Clamp to percentile and normalize. */
             float normalized_quality = std::min(1.0f, info.quality / percentile);
-            float data_cost = (1.0f - normalized_quality) * MRF_MAX_ENERGYTERM;
+            DataCost data_cost = quantize_data_cost(1.0f - normalized_quality);
             data_costs->set_value(i, info.view_id, data_cost);
         }
 
@@ -314,7 +323,6 @@ calculate_data_costs(mve::TriangleMesh::ConstPtr mesh, std::vector<TextureView>
 
     assert(num_faces < std::numeric_limits<std::uint32_t>::max());
     assert(num_views < std::numeric_limits<std::uint16_t>::max());
-    assert(MRF_MAX_ENERGYTERM < std::numeric_limits<float>::max());
 
     FaceProjectionInfos face_projection_infos(num_faces);
     calculate_face_projection_infos(mesh, texture_views, settings, &face_projection_infos);
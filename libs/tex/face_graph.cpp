@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "face_graph.h"
+
+TEX_NAMESPACE_BEGIN
+
+/**
+  * Calls func(face1, face2) for all ordered pairs of distinct faces sharing an
+  * edge within a sorted bucket of (larger vertex, face) keys.
+  */
+template <typename Func> void
+for_each_adjacent_pair(std::uint64_t const * begin, std::uint64_t const * end, Func const & func) {
+    for (std::uint64_t const * run = begin; run != end;) {
+        std::uint64_t const * run_end = run + 1;
+        while (run_end != end && *run_end >> 32 == *run >> 32) ++run_end;
+        for (std::uint64_t const * a = run; a != run_end; ++a) {
+            for (std::uint64_t const * b = run; b != run_end; ++b) {
+                std::uint32_t const face1 = static_cast<std::uint32_t>(*a);
+                std::uint32_t const face2 = static_cast<std::uint32_t>(*b);
+                if (face1 != face2) func(face1, face2);
+            }
+        }
+        run = run_end;
+    }
+}
+
+FaceGraph::FaceGraph(mve::TriangleMesh::ConstPtr mesh) {
+    mve::TriangleMesh::FaceList const & faces = mesh->get_faces();
+    std::size_t const num_vertices = mesh->get_vertices().size();
+    std::size_t const num_faces = faces.size() / 3;
+    std::size_t const num_corners = faces.size();
+
+    /* Count the edges of each smaller vertex. */
+    std::unique_ptr<std::atomic<std::uint32_t>[]> counts(
+        new std::atomic<std::uint32_t>[std::max(num_vertices, num_faces)]);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_corners; ++i) {
+        std::size_t const next = i - i % 3 + (i + 1) % 3;
+        std::size_t const v = std::min(faces[i], faces[next]);
+        counts[v].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<std::size_t> edge_offsets(num_vertices + 1);
+    edge_offsets[0] = 0;
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        edge_offsets[i + 1] = edge_offsets[i] + counts[i].load(std::memory_order_relaxed);
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    /* Scatter the edges as (larger vertex, face) keys and sort each bucket -
+     * faces sharing an edge become consecutive. */
+    std::vector<std::uint64_t> keys(num_corners);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_corners; ++i) {
+        std::size_t const next = i - i % 3 + (i + 1) % 3;
+        std::size_t const v1 = std::min(faces[i], faces[next]);
+        std::uint64_t const v2 = std::max(faces[i], faces[next]);
+        std::uint32_t const pos = counts[v1].fetch_add(1, std::memory_order_relaxed);
+        keys[edge_offsets[v1] + pos] = (v2 << 32) | static_cast<std::uint32_t>(i / 3);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        std::sort(keys.begin() + edge_offsets[i], keys.begin() + edge_offsets[i + 1]);
+    }
+
+    /* Count the neighbors of each face. */
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        for_each_adjacent_pair(keys.data() + edge_offsets[i], keys.data() + edge_offsets[i + 1],
+            [&] (std::uint32_t face1, std::uint32_t) {
+                counts[face1].fetch_add(1, std::memory_order_relaxed);
+            });
+    }
+
+    std::vector<std::size_t> scatter_offsets(num_faces + 1);
+    scatter_offsets[0] = 0;
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        scatter_offsets[i + 1] = scatter_offsets[i] + counts[i].load(std::memory_order_relaxed);
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    std::vector<std::uint32_t> scattered(scatter_offsets.back());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        for_each_adjacent_pair(keys.data() + edge_offsets[i], keys.data() + edge_offsets[i + 1],
+            [&] (std::uint32_t face1, std::uint32_t face2) {
+                std::uint32_t const pos = counts[face1].fetch_add(1, std::memory_order_relaxed);
+                scattered[scatter_offsets[face1] + pos] = face2;
+            });
+    }
+
+    /* Faces sharing more than one edge are listed repeatedly - sort and compact. */
+    std::vector<std::size_t> sizes(num_faces);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        auto begin = scattered.begin() + scatter_offsets[i];
+        auto end = scattered.begin() + scatter_offsets[i + 1];
+        std::sort(begin, end);
+        sizes[i] = std::unique(begin, end) - begin;
+    }
+
+    offsets.resize(num_faces + 1);
+    offsets[0] = 0;
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        offsets[i + 1] = offsets[i] + sizes[i];
+    }
+
+    adj_nodes.resize(offsets.back());
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        std::copy(scattered.begin() + scatter_offsets[i],
+            scattered.begin() + scatter_offsets[i] + sizes[i], adj_nodes.begin() + offsets[i]);
+    }
+}
+
+FaceGraph::FaceGraph(UniGraph const & graph, std::vector<bool> const & isolated) {
+    std::size_t const num_nodes = graph.num_nodes();
+
+    offsets.resize(num_nodes + 1);
+    offsets[0] = 0;
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        std::size_t num_adj_nodes = 0;
+        if (!isolated[i]) {
+            for (std::size_t adj_node : graph.get_adj_nodes(i)) {
+                if (!isolated[adj_node]) num_adj_nodes += 1;
+            }
+        }
+        offsets[i + 1] = offsets[i] + num_adj_nodes;
+    }
+
+    adj_nodes.resize(offsets.back());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        if (isolated[i]) continue;
+        std::size_t pos = offsets[i];
+        for (std::size_t adj_node : graph.get_adj_nodes(i)) {
+            if (!isolated[adj_node]) adj_nodes[pos++] = static_cast<std::uint32_t>(adj_node);
+        }
+    }
+}
+
+void
+FaceGraph::get_components(std::vector<std::vector<std::size_t> > * components) const {
+    std::vector<bool> used(num_nodes(), false);
+
+    for (std::size_t i = 0; i < num_nodes(); ++i) {
+        if (used[i]) continue;
+
+        components->push_back(std::vector<std::size_t>(1, i));
+        std::vector<std::size_t> & component = components->back();
+        used[i] = true;
+
+        /* The component doubles as breadth first queue. */
+        for (std::size_t j = 0; j < component.size(); ++j) {
+            for (std::size_t adj_node : get_adj_nodes(component[j])) {
+                if (used[adj_node]) continue;
+                used[adj_node] = true;
+                component.push_back(adj_node);
+            }
+        }
+    }
+}
+
+TEX_NAMESPACE_END
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TEX_FACEGRAPH_HEADER
+#define TEX_FACEGRAPH_HEADER
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <mve/mesh.h>
+
+#include "defines.h"
+#include "uni_graph.h"
+
+TEX_NAMESPACE_BEGIN
+
+/**
+  * Class representing the immutable adjacency of the faces of a triangle mesh
+  * (faces sharing an edge) in compressed row storage.
+  * Offers the reading part of the interface of UniGraph.
+  */
+class FaceGraph {
+    public:
+        /** Range of the neighbors of a face. */
+        class AdjNodes {
+            private:
+                std::uint32_t const * first;
+                std::uint32_t const * last;
+
+            public:
+                AdjNodes(std::uint32_t const * first, std::uint32_t const * last)
+                    : first(first), last(last) {}
+
+                std::uint32_t const * begin(void) const { return first; }
+                std::uint32_t const * end(void) const { return last; }
+                std::size_t size(void) const { return last - first; }
+                std::size_t operator[](std::size_t i) const { return first[i]; }
+        };
+
+    private:
+        std::vector<std::size_t> offsets;
+        std::vector<std::uint32_t> adj_nodes;
+
+    public:
+        /**
+          * Builds the adjacency in parallel: the edges of all faces are sorted by
+          * their key (smaller vertex, larger vertex) with a counting sort over the
+          * smaller vertex, faces with equal keys share the edge.
+          * The neighbors of each face are sorted by id.
+          */
+        FaceGraph(mve::TriangleMesh::ConstPtr mesh);
+
+        /**
+          * Copies the adjacency of graph (keeping the order of the neighbors),
+          * omitting all edges of isolated nodes.
+          */
+        FaceGraph(UniGraph const & graph, std::vector<bool> const & isolated);
+
+        /** Returns the number of nodes. */
+        std::size_t num_nodes(void) const;
+
+        /** Returns the number of edges. */
+        std::size_t num_edges(void) const;
+
+        /** Returns the neighbors of the given node. */
+        AdjNodes get_adj_nodes(std::size_t node) const;
+
+        /**
+          * Fills the given vector with the connected components of the graph
+          * (in the same order as UniGraph::get_subgraphs for equal labels).
+          */
+        void get_components(std::vector<std::vector<std::size_t> > * components) const;
+};
+
+inline std::size_t
+FaceGraph::num_nodes(void) const {
+    return offsets.size() - 1;
+}
+
+inline std::size_t
+FaceGraph::num_edges(void) const {
+    return adj_nodes.size() / 2;
+}
+
+inline FaceGraph::AdjNodes
+FaceGraph::get_adj_nodes(std::size_t node) const {
+    assert(node < num_nodes());
+    return AdjNodes(adj_nodes.data() + offsets[node], adj_nodes.data() + offsets[node + 1]);
+}
+
+TEX_NAMESPACE_END
+
+#endif /* TEX_FACEGRAPH_HEADER */
@@ -427,12 +427,18 @@ generate_texture_patches(UniGraph const & graph, mve::TriangleMesh::ConstPtr mes
     std::size_t num_patches = 0;
 
     std::cout << "\tRunning... " << std::flush;
+
+    /* Subgraphs of all labels - label 0 denotes unseen faces. */
+    std::vector<std::vector<std::vector<std::size_t> > > label_subgraphs;
+    graph.get_all_subgraphs(&label_subgraphs);
+    label_subgraphs.resize(std::max(label_subgraphs.size(), texture_views->size() + 1));
+
     #pragma omp parallel for schedule(dynamic)
     for (std::size_t i = 0; i < texture_views->size(); ++i) {
 
-        std::vector<std::vector<std::size_t> > subgraphs;
         int const label = i + 1;
-        graph.get_subgraphs(label, &subgraphs);
+        std::vector<std::vector<std::size_t> > const & subgraphs = label_subgraphs[label];
+        if (subgraphs.empty()) continue;
 
         TextureView * texture_view = &texture_views->at(i);
         texture_view->load_image();
@@ -500,8 +506,7 @@ generate_texture_patches(UniGraph const & graph, mve::TriangleMesh::ConstPtr mes
 
     {
         std::vector<std::size_t> unseen_faces;
-        std::vector<std::vector<std::size_t> > subgraphs;
-        graph.get_subgraphs(0, &subgraphs);
+        std::vector<std::vector<std::size_t> > const & subgraphs = label_subgraphs[0];
 
         #pragma omp parallel for schedule(dynamic)
         for (std::size_t i = 0; i < subgraphs.size(); ++i) {
@@ -7,61 +7,117 @@
  * of the BSD 3-Clause license. See the LICENSE.txt file for details.
  */
 
+#include <algorithm>
+#include <memory>
+
+#include <util/exception.h>
 #include <util/timer.h>
 #include <util/tokenizer.h>
 #include <mve/image_io.h>
 #include <mve/image_tools.h>
 #include <mve/bundle_io.h>
-#include <mve/scene.h>
+#include <mve/view.h>
 
 #include "progress_counter.h"
+#include "shared_scene.h"
 #include "texturing.h"
 
 TEX_NAMESPACE_BEGIN
 
+/**
+  * Parallel loaders create the texture views into slots which are indexed by
+  * the view's position within the input. Moving them into texture_views in slot
+  * order keeps the order (and thus the labels) independent of thread timing.
+  */
+typedef std::vector<std::unique_ptr<TextureView> > TextureViewSlots;
+
+void
+append_texture_views(TextureViewSlots * slots, std::vector<TextureView> * texture_views) {
+    texture_views->reserve(texture_views->size() + slots->size());
+    for (std::size_t i = 0; i < slots->size(); ++i) {
+        if (slots->at(i) == nullptr) continue;
+        texture_views->push_back(std::move(*slots->at(i)));
+        slots->at(i).reset();
+    }
+}
+
+/**
+  * Loads the views of the MVE scene directly instead of via mve::Scene::create,
+  * which reads the meta data of all views serially - with many views the
+  * loading is dominated by these reads.
+  */
 void
 from_mve_scene(std::string const & scene_dir, std::string const & image_name,
     std::vector<TextureView> * texture_views) {
 
-    mve::Scene::Ptr scene;
-    try {
-        scene = mve::Scene::create(scene_dir);
-    } catch (std::exception& e) {
-        std::cerr << "Could not open scene: " << e.what() << std::endl;
+    std::string const views_dir = util::fs::join_path(scene_dir, "views");
+    if (!util::fs::dir_exists(views_dir.c_str())) {
+        std::cerr << "Could not open scene: " << views_dir
+            << " does not exist" << std::endl;
         std::exit(EXIT_FAILURE);
     }
-    std::size_t num_views = scene->get_views().size();
-    texture_views->reserve(num_views);
+
+    std::vector<std::string> view_dirs;
+    util::fs::Directory dir(views_dir);
+    for (util::fs::File const & file : dir) {
+        if (!file.is_dir || util::string::right(file.name, 4) != ".mve") continue;
+        view_dirs.push_back(file.get_absolute_name());
+    }
+    std::size_t num_views = view_dirs.size();
+
+    TextureViewSlots slots(num_views);
 
     ProgressCounter view_counter("\tLoading", num_views);
+    #pragma omp parallel for schedule(dynamic)
     for (std::size_t i = 0; i < num_views; ++i) {
         view_counter.progress<SIMPLE>();
 
-        mve::View::Ptr view = scene->get_view_by_id(i);
-        if (view == NULL) {
-            view_counter.inc();
-            continue;
+        mve::View::Ptr view;
+        try {
+            view = mve::View::create(view_dirs[i]);
+        } catch (std::exception& e) {
+            #pragma omp critical
+            {
+                std::cerr << "Could not open view " << view_dirs[i] << ": "
+                    << e.what() << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
         }
 
         if (!view->has_image(image_name, mve::IMAGE_TYPE_UINT8)) {
+            #pragma omp critical
             std::cout << "Warning: View " << view->get_name() << " has no byte image "
                 << image_name << std::endl;
+            view_counter.inc();
             continue;
         }
 
         mve::View::ImageProxy const * image_proxy = view->get_image_proxy(image_name);
 
+        #pragma omp critical
         if (image_proxy->channels < 3) {
             std::cerr << "Image " << image_name << " of view " <<
                 view->get_name() << " is not a color image!" << std::endl;
             exit(EXIT_FAILURE);
         }
 
-        texture_views->push_back(
-            TextureView(view->get_id(), view->get_camera(), util::fs::abspath(
-            util::fs::join_path(view->get_directory(), image_proxy->filename))));
+        /* The image proxy already knows the dimensions - no need to open the image file. */
+        std::string image_file = util::fs::abspath(
+            util::fs::join_path(view->get_directory(), image_proxy->filename));
+        slots[i].reset(new TextureView(view->get_id(), view->get_camera(), image_file,
+            image_proxy->width, image_proxy->height));
+
         view_counter.inc();
     }
+
+    /* Order the views by id like mve::Scene does (the directory order is arbitrary). */
+    std::stable_sort(slots.begin(), slots.end(),
+        [] (std::unique_ptr<TextureView> const & a, std::unique_ptr<TextureView> const & b) {
+            if (a == nullptr || b == nullptr) return a != nullptr && b == nullptr;
+            return a->get_id() < b->get_id();
+        });
+
+    append_texture_views(&slots, texture_views);
 }
 
 void
@@ -106,6 +162,8 @@ from_images_and_camera_files(std::string const & path, std::vector<TextureView>
         }
     }
 
+    TextureViewSlots slots(files.size() / 2);
+
     ProgressCounter view_counter("\tLoading", files.size() / 2);
     #pragma omp parallel for
     for (std::size_t i = 0; i < files.size(); i += 2) {
@@ -162,11 +220,12 @@ from_images_and_camera_files(std::string const & path, std::vector<TextureView>
             mve::image::save_png_file(image, image_file);
         }
 
-        #pragma omp critical
-        texture_views->push_back(TextureView(i / 2, cam_info, image_file));
+        slots[i / 2].reset(new TextureView(i / 2, cam_info, image_file));
 
         view_counter.inc();
     }
+
+    append_texture_views(&slots, texture_views);
 }
 
 void
@@ -175,6 +234,8 @@ from_nvm_scene(std::string const & nvm_file, std::vector<TextureView> * texture_
     mve::Bundle::Ptr bundle = mve::load_nvm_bundle(nvm_file, &nvm_cams);
     mve::Bundle::Cameras& cameras = bundle->get_cameras();
 
+    TextureViewSlots slots(cameras.size());
+
     ProgressCounter view_counter("\tLoading", cameras.size());
     #pragma omp parallel for
     for (std::size_t i = 0; i < cameras.size(); ++i) {
@@ -193,15 +254,35 @@ from_nvm_scene(std::string const & nvm_file, std::vector<TextureView> * texture_
         std::string image_file = std::string("/tmp/") + util::fs::basename(nvm_cam.filename);
         mve::image::save_png_file(image, image_file);
 
-        #pragma omp critical
-        texture_views->push_back(TextureView(i, mve_cam, image_file));
+        /* The undistorted image is at hand - no need to reload its header. */
+        slots[i].reset(new TextureView(i, mve_cam, image_file,
+            image->width(), image->height()));
 
         view_counter.inc();
     }
+
+    append_texture_views(&slots, texture_views);
 }
 
 void
 generate_texture_views(std::string const & in_scene, std::vector<TextureView> * texture_views) {
+    /* SHARED_SCENE */
+    if (is_shared_scene(in_scene)) {
+        try {
+            MappedFile::Ptr scene = attach_shared_scene(in_scene);
+            load_shared_views(*scene, texture_views);
+        } catch (util::FileException & e) {
+            std::cerr << "Could not attach shared scene: " << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        /* Never fall back to interpreting the descriptor as a path. */
+        if (texture_views->empty()) {
+            std::cerr << "Shared scene " << in_scene << " does not contain any views." << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        return;
+    }
+
     util::Tokenizer tok;
     tok.split(in_scene, ':', true);
 
@@ -233,7 +314,8 @@ generate_texture_views(std::string const & in_scene, std::vector<TextureView> *
             << "A input descriptor can be:" << std::endl
             << "BUNDLE_FILE - a bundle file (currently onle .nvm files are supported)" << std::endl
             << "SCENE_FOLDER - a folder containing images and .cam files" << std::endl
-            << "MVE_SCENE::EMBEDDING - a mve scene and embedding" << std::endl;
+            << "MVE_SCENE::EMBEDDING - a mve scene and embedding" << std::endl
+            << "SHARED_SCENE - a shared memory object (shm:NAME) or descriptor (fd:N)" << std::endl;
         exit(EXIT_FAILURE);
     }
 }
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+
+#include <mve/mesh_io_ply.h>
+#include <util/exception.h>
+
+#include "mapped_file.h"
+#include "shared_scene.h"
+#include "texturing.h"
+
+TEX_NAMESPACE_BEGIN
+
+/** Scalar types of the ply format. */
+enum PlyType {
+    PLY_INVALID = 0, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16,
+    PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+};
+
+PlyType
+parse_ply_type(std::string const & name) {
+    if (name == "char" || name == "int8") return PLY_INT8;
+    if (name == "uchar" || name == "uint8") return PLY_UINT8;
+    if (name == "short" || name == "int16") return PLY_INT16;
+    if (name == "ushort" || name == "uint16") return PLY_UINT16;
+    if (name == "int" || name == "int32") return PLY_INT32;
+    if (name == "uint" || name == "uint32") return PLY_UINT32;
+    if (name == "float" || name == "float32") return PLY_FLOAT32;
+    if (name == "double" || name == "float64") return PLY_FLOAT64;
+    return PLY_INVALID;
+}
+
+std::size_t
+ply_type_size(PlyType type) {
+    switch (type) {
+        case PLY_INT8: case PLY_UINT8: return 1;
+        case PLY_INT16: case PLY_UINT16: return 2;
+        case PLY_INT32: case PLY_UINT32: case PLY_FLOAT32: return 4;
+        case PLY_FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+/** Reads a (potentially unaligned) little endian value of the given type. */
+template <typename T> T
+read_ply_value(char const * ptr, PlyType type) {
+    switch (type) {
+        case PLY_INT8: { std::int8_t v; std::memcpy(&v, ptr, 1); return static_cast<T>(v); }
+        case PLY_UINT8: { std::uint8_t v; std::memcpy(&v, ptr, 1); return static_cast<T>(v); }
+        case PLY_INT16: { std::int16_t v; std::memcpy(&v, ptr, 2); return static_cast<T>(v); }
+        case PLY_UINT16: { std::uint16_t v; std::memcpy(&v, ptr, 2); return static_cast<T>(v); }
+        case PLY_INT32: { std::int32_t v; std::memcpy(&v, ptr, 4); return static_cast<T>(v); }
+        case PLY_UINT32: { std::uint32_t v; std::memcpy(&v, ptr, 4); return static_cast<T>(v); }
+        case PLY_FLOAT32: { float v; std::memcpy(&v, ptr, 4); return static_cast<T>(v); }
+        case PLY_FLOAT64: { double v; std::memcpy(&v, ptr, 8); return static_cast<T>(v); }
+        default: return T(0);
+    }
+}
+
+struct PlyProperty {
+    std::string name;
+    PlyType type;
+    /* Only set for list properties. */
+    PlyType count_type;
+    std::size_t offset;
+};
+
+struct PlyElement {
+    std::string name;
+    std::size_t count;
+    std::vector<PlyProperty> properties;
+};
+
+/**
+  * Returns whether the element only has the given properties - other attributes
+  * are left to the MVE loader.
+  */
+bool
+has_only_ply_properties(PlyElement const & element, std::vector<std::string> const & names) {
+    for (PlyProperty const & property : element.properties) {
+        if (std::find(names.begin(), names.end(), property.name) == names.end()) return false;
+    }
+    return true;
+}
+
+/** Reads a color channel - integral channels are normalized to [0, 1]. */
+float
+read_ply_color(char const * ptr, PlyType type) {
+    float value = read_ply_value<float>(ptr, type);
+    if (type == PLY_UINT8) value /= 255.0f;
+    if (type == PLY_UINT16) value /= 65535.0f;
+    return value;
+}
+
+/** Returns the offset of the scalar property with the given name or -1. */
+int
+find_ply_property(PlyElement const & element, std::string const & name, PlyType * type) {
+    for (PlyProperty const & property : element.properties) {
+        if (property.name != name || property.count_type != PLY_INVALID) continue;
+        *type = property.type;
+        return static_cast<int>(property.offset);
+    }
+    return -1;
+}
+
+/**
+  * Parses a binary little endian ply file with a vertex and a triangle face element
+  * from a memory mapping - vertices and faces are parsed in parallel since every
+  * record has a fixed size. Vertices may have normals and colors.
+  * Returns NULL if the file is in a different format or has further attributes.
+  * @throws util::Exception if the file is corrupt.
+  */
+mve::TriangleMesh::Ptr
+load_binary_ply_mesh(std::string const & filename) {
+    static std::uint16_t const one = 1;
+    bool const little_endian_host = *reinterpret_cast<std::uint8_t const *>(&one) == 1;
+    if (!little_endian_host) return NULL;
+
+    MappedFile file(filename);
+    char const * const data = file.get_data();
+    std::size_t const size = file.get_size();
+
+    static std::string const end_header = "end_header\n";
+    char const * header_end = std::search(data, data + size,
+        end_header.begin(), end_header.end());
+    if (header_end == data + size) return NULL;
+
+    std::stringstream header(std::string(data, header_end));
+    std::vector<PlyElement> elements;
+    std::string line;
+    bool binary_little_endian = false;
+    while (std::getline(header, line)) {
+        std::stringstream ss(line);
+        std::string keyword;
+        ss >> keyword;
+        if (keyword == "format") {
+            std::string format;
+            ss >> format;
+            binary_little_endian = (format == "binary_little_endian");
+        } else if (keyword == "element") {
+            PlyElement element;
+            ss >> element.name >> element.count;
+            elements.push_back(element);
+        } else if (keyword == "property") {
+            if (elements.empty()) return NULL;
+            PlyProperty property;
+            std::string type;
+            ss >> type;
+            if (type == "list") {
+                std::string count_type;
+                ss >> count_type >> type;
+                property.count_type = parse_ply_type(count_type);
+                if (property.count_type == PLY_INVALID) return NULL;
+            } else {
+                property.count_type = PLY_INVALID;
+            }
+            property.type = parse_ply_type(type);
+            if (property.type == PLY_INVALID) return NULL;
+            ss >> property.name;
+            elements.back().properties.push_back(property);
+        }
+    }
+    if (!binary_little_endian) return NULL;
+
+    /* Determine the record layout of the vertex and face element. */
+    std::size_t offset = (header_end - data) + end_header.size();
+    std::size_t vertex_offset = 0, face_offset = 0;
+    std::size_t vertex_stride = 0, face_stride = 0;
+    PlyElement const * vertex_element = NULL;
+    PlyElement const * face_element = NULL;
+    PlyProperty const * index_property = NULL;
+    for (PlyElement & element : elements) {
+        bool is_vertex = element.name == "vertex";
+        bool is_face = element.name == "face";
+
+        std::size_t stride = 0;
+        for (PlyProperty & property : element.properties) {
+            property.offset = stride;
+            if (property.count_type == PLY_INVALID) {
+                stride += ply_type_size(property.type);
+            } else if (is_face && index_property == NULL
+                && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                /* Assume triangles - verified while parsing. */
+                index_property = &property;
+                stride += ply_type_size(property.count_type) + 3 * ply_type_size(property.type);
+            } else {
+                /* Records of varying size. */
+                return NULL;
+            }
+        }
+
+        if (is_vertex) {
+            vertex_element = &element;
+            vertex_offset = offset;
+            vertex_stride = stride;
+        } else if (is_face) {
+            if (index_property == NULL) return NULL;
+            face_element = &element;
+            face_offset = offset;
+            face_stride = stride;
+        }
+
+        /* Trailing elements are ignored. */
+        if (vertex_element != NULL && face_element != NULL) break;
+
+        offset += element.count * stride;
+    }
+    if (vertex_element == NULL || face_element == NULL) return NULL;
+
+    /* Fall back to the MVE loader for attributes which are not parsed here. */
+    if (!has_only_ply_properties(*vertex_element, {"x", "y", "z", "nx", "ny", "nz",
+            "red", "green", "blue", "alpha"})
+        || !has_only_ply_properties(*face_element, {index_property->name})) {
+        return NULL;
+    }
+
+    if (face_offset + face_element->count * face_stride > size
+        || vertex_offset + vertex_element->count * vertex_stride > size) {
+        throw util::Exception("PLY file is truncated");
+    }
+    char const * const vertex_data = data + vertex_offset;
+    char const * const face_data = data + face_offset;
+
+    PlyType pos_type[3], normal_type[3], color_type[4];
+    int pos_offset[3], normal_offset[3], color_offset[4];
+    char const * pos_names[] = {"x", "y", "z"};
+    char const * normal_names[] = {"nx", "ny", "nz"};
+    char const * color_names[] = {"red", "green", "blue", "alpha"};
+    bool has_normals = true;
+    bool has_colors = true;
+    for (int i = 0; i < 3; ++i) {
+        pos_offset[i] = find_ply_property(*vertex_element, pos_names[i], &pos_type[i]);
+        if (pos_offset[i] < 0) return NULL;
+        normal_offset[i] = find_ply_property(*vertex_element, normal_names[i], &normal_type[i]);
+        has_normals = has_normals && normal_offset[i] >= 0;
+        color_offset[i] = find_ply_property(*vertex_element, color_names[i], &color_type[i]);
+        has_colors = has_colors && color_offset[i] >= 0;
+    }
+    /* Alpha is optional. */
+    color_offset[3] = find_ply_property(*vertex_element, color_names[3], &color_type[3]);
+    /* Incomplete normals or colors are left to the MVE loader as well. */
+    for (int i = 0; i < 4; ++i) {
+        if (i < 3 && !has_normals && normal_offset[i] >= 0) return NULL;
+        if (!has_colors && color_offset[i] >= 0) return NULL;
+    }
+
+    mve::TriangleMesh::Ptr mesh = mve::TriangleMesh::create();
+    mve::TriangleMesh::VertexList & vertices = mesh->get_vertices();
+    mve::TriangleMesh::NormalList & normals = mesh->get_vertex_normals();
+    mve::TriangleMesh::ColorList & colors = mesh->get_vertex_colors();
+    mve::TriangleMesh::FaceList & faces = mesh->get_faces();
+
+    std::size_t const num_vertices = vertex_element->count;
+    vertices.resize(num_vertices);
+    if (has_normals) normals.resize(num_vertices);
+    if (has_colors) colors.resize(num_vertices);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        char const * record = vertex_data + i * vertex_stride;
+        for (int j = 0; j < 3; ++j) {
+            vertices[i][j] = read_ply_value<float>(record + pos_offset[j], pos_type[j]);
+        }
+        if (has_normals) {
+            for (int j = 0; j < 3; ++j) {
+                normals[i][j] = read_ply_value<float>(record + normal_offset[j], normal_type[j]);
+            }
+        }
+        if (has_colors) {
+            for (int j = 0; j < 3; ++j) {
+                colors[i][j] = read_ply_color(record + color_offset[j], color_type[j]);
+            }
+            colors[i][3] = color_offset[3] < 0 ? 1.0f
+                : read_ply_color(record + color_offset[3], color_type[3]);
+        }
+    }
+
+    std::size_t const num_faces = face_element->count;
+    std::size_t const index_size = ply_type_size(index_property->type);
+    std::size_t const count_size = ply_type_size(index_property->count_type);
+    std::atomic<bool> triangles(true);
+    std::atomic<bool> valid_indices(true);
+    faces.resize(num_faces * 3);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        char const * record = face_data + i * face_stride + index_property->offset;
+        if (read_ply_value<std::size_t>(record, index_property->count_type) != 3) {
+            triangles = false;
+            continue;
+        }
+        for (std::size_t j = 0; j < 3; ++j) {
+            std::size_t index = read_ply_value<std::size_t>(
+                record + count_size + j * index_size, index_property->type);
+            if (index >= num_vertices) valid_indices = false;
+            faces[i * 3 + j] = static_cast<unsigned int>(index);
+        }
+    }
+
+    /* Non-triangular faces have a varying record size. */
+    if (!triangles) return NULL;
+
+    if (!valid_indices) throw util::Exception("PLY file contains invalid vertex indices");
+
+    return mesh;
+}
+
+mve::TriangleMesh::Ptr
+load_mesh(std::string const & filename) {
+    if (is_shared_scene(filename)) {
+        MappedFile::Ptr scene = attach_shared_scene(filename);
+        return load_shared_mesh(*scene);
+    }
+
+    mve::TriangleMesh::Ptr mesh = load_binary_ply_mesh(filename);
+    if (mesh != NULL) return mesh;
+
+    return mve::geom::load_ply_mesh(filename);
+}
+
+TEX_NAMESPACE_END
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <util/exception.h>
+
+#include "mapped_file.h"
+
+TEX_NAMESPACE_BEGIN
+
+MappedFile::MappedFile(std::string const & filename)
+    : data(nullptr), size(0) {
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw util::FileException(filename, std::strerror(errno));
+
+    try {
+        map(fd, filename);
+    } catch (util::FileException &) {
+        ::close(fd);
+        throw;
+    }
+
+    /* The mapping stays valid after closing the descriptor. */
+    ::close(fd);
+}
+
+MappedFile::MappedFile(int fd, std::string const & name)
+    : data(nullptr), size(0) {
+    map(fd, name);
+}
+
+void
+MappedFile::map(int fd, std::string const & name) {
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+        throw util::FileException(name, std::strerror(errno));
+
+    size = static_cast<std::size_t>(info.st_size);
+
+    /* Mapping zero bytes is invalid - an empty file yields an empty mapping. */
+    if (size == 0) return;
+
+    data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        throw util::FileException(name, std::strerror(errno));
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) ::munmap(data, size);
+}
+
+TEX_NAMESPACE_END
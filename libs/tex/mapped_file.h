@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TEX_MAPPEDFILE_HEADER
+#define TEX_MAPPEDFILE_HEADER
+
+#include <memory>
+#include <string>
+
+#include "defines.h"
+
+TEX_NAMESPACE_BEGIN
+
+/**
+  * Class representing a read-only memory mapping of a whole file.
+  * The mapping is released on destruction.
+  */
+class MappedFile {
+    public:
+        typedef std::shared_ptr<MappedFile> Ptr;
+
+    private:
+        void * data;
+        std::size_t size;
+
+        MappedFile(MappedFile const &) = delete;
+        MappedFile & operator=(MappedFile const &) = delete;
+
+        void map(int fd, std::string const & name);
+
+    public:
+        /**
+          * Maps the file given by filename.
+          * @throws util::FileException if the file cannot be opened or mapped.
+          */
+        MappedFile(std::string const & filename);
+        /**
+          * Maps the whole file (e.g. shared memory object or memfd) referred to by
+          * the given open descriptor, name is only used in error messages.
+          * The descriptor is not closed.
+          * @throws util::FileException if the file cannot be mapped.
+          */
+        MappedFile(int fd, std::string const & name);
+        ~MappedFile();
+
+        static MappedFile::Ptr create(std::string const & filename);
+        static MappedFile::Ptr create(int fd, std::string const & name);
+
+        /** Returns a pointer to the first byte of the mapping. */
+        char const * get_data(void) const;
+        /** Returns the size of the mapping in bytes. */
+        std::size_t get_size(void) const;
+};
+
+inline MappedFile::Ptr
+MappedFile::create(std::string const & filename) {
+    return Ptr(new MappedFile(filename));
+}
+
+inline MappedFile::Ptr
+MappedFile::create(int fd, std::string const & name) {
+    return Ptr(new MappedFile(fd, name));
+}
+
+inline char const *
+MappedFile::get_data(void) const {
+    return static_cast<char const *>(data);
+}
+
+inline std::size_t
+MappedFile::get_size(void) const {
+    return size;
+}
+
+TEX_NAMESPACE_END
+
+#endif /* TEX_MAPPEDFILE_HEADER */
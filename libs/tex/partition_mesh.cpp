@@ -14,8 +14,20 @@
 #include <cmath>
 #include <random>
 #include <iterator>
+#include <limits>
 
-#include "uni_graph.h"
+#include "partition_mesh.h"
+
+namespace {
+
+/** Compares two (label, frequency) pairs by frequency. */
+bool
+less_frequent(std::pair<const std::size_t, std::size_t> const & a,
+    std::pair<const std::size_t, std::size_t> const & b) {
+    return a.second < b.second;
+}
+
+}
 
 /**
  * Finds connected sets of vertices within the given graph and gives all connected vertices the same label.
@@ -43,7 +55,7 @@ label_connected_subgraphs(UniGraph * graph)
 
         /* Put first unvisited node into queue to start a new flooding algorithm from there. */
         std::vector<std::size_t> queue;
-        queue.push_back(*first_unvisited_node);
+        queue.push_back(std::distance(visited.begin(), first_unvisited_node));
 
         /* Flooding algorithm */
         while (!queue.empty()) {
@@ -78,8 +90,7 @@ std::size_t occurences_of_most_frequent_label(UniGraph const * graph) {
     for (std::size_t node = 0; node < graph->num_nodes(); ++node)
         label_frequencies[graph->get_label(node)]++;
 
-    const std::size_t most_frequent_label = std::max_element(label_frequencies.begin(), label_frequencies.end(), label_frequencies.value_comp())->second;
-    return label_frequencies.at(most_frequent_label);
+    return std::max_element(label_frequencies.begin(), label_frequencies.end(), less_frequent)->second;
 }
 
 /**
@@ -117,9 +128,10 @@ partition_connected_component(UniGraph * graph, std::size_t label_of_connected_c
     std::default_random_engine generator;
     std::uniform_int_distribution<std::size_t> distribution(0, nodes.size() - 1);
     for(std::size_t partition = 0; partition < num_partitions; ++partition) {
-        Node centroid = std::numeric_limits<Node>::max();
-        while (std::find(centroids.begin(), centroids.end(), centroid) != centroids.end())
+        Node centroid;
+        do {
             centroid = nodes.at(distribution(generator));
+        } while (std::find(centroids.begin(), centroids.end(), centroid) != centroids.end());
         centroids.push_back(centroid);
     }
 
@@ -220,7 +232,7 @@ reassign_labels_by_relative_frequency(UniGraph * graph)
     /* Insert elements into vector in a sorted way. */
     std::vector<std::size_t> sorted_labels;
     while (!label_frequencies.empty()) {
-        auto iterator_to_largest_label = std::max_element(label_frequencies.begin(), label_frequencies.end(), label_frequencies.value_comp());
+        auto iterator_to_largest_label = std::max_element(label_frequencies.begin(), label_frequencies.end(), less_frequent);
         sorted_labels.push_back(iterator_to_largest_label->first);
         label_frequencies.erase(iterator_to_largest_label);
     }
@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2015, Michael Waechter
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TEX_PARTITIONMESH_HEADER
+#define TEX_PARTITIONMESH_HEADER
+
+#include "uni_graph.h"
+
+/**
+ * Partitions each connected component of the graph by region growing into partitions of
+ * about the size of the largest component divided by min_num_partitions.
+ * Afterwards the label of each node is its partition, numbered by size (descending).
+ */
+void
+partition_mesh(UniGraph * graph, std::size_t min_num_partitions);
+
+#endif /* TEX_PARTITIONMESH_HEADER */
@@ -8,22 +8,26 @@
  */
 
 #include "texturing.h"
+#include "vertex_face_adjacency.h"
 
 TEX_NAMESPACE_BEGIN
 
-std::size_t remove_redundant_faces(mve::MeshInfo const & mesh_info, mve::TriangleMesh::Ptr mesh) {
+std::size_t remove_redundant_faces(mve::TriangleMesh::Ptr mesh) {
+    VertexFaceAdjacency adjacency(mesh);
+
     mve::TriangleMesh::FaceList & faces = mesh->get_faces();
-    mve::TriangleMesh::FaceList new_faces;
-    new_faces.reserve(faces.size());
+    std::size_t const num_faces = faces.size() / 3;
 
-    std::size_t num_redundant = 0;
-    for (std::size_t i = 0; i < faces.size(); i += 3) {
-        std::size_t face_id = i / 3;
-        bool redundant = false;
-        for (std::size_t j = 0; !redundant && j < 3; ++j) {
-            mve::MeshInfo::AdjacentFaces const & adj_faces = mesh_info[faces[i + j]].faces;
-            for (std::size_t k = 0; !redundant && k < adj_faces.size(); ++k) {
-                std::size_t adj_face_id = adj_faces[k];
+    std::vector<char> redundant(num_faces, 0);
+    #pragma omp parallel for
+    for (std::size_t face_id = 0; face_id < num_faces; ++face_id) {
+        std::size_t const i = face_id * 3;
+        bool is_redundant = false;
+        for (std::size_t j = 0; !is_redundant && j < 3; ++j) {
+            std::uint32_t const * adj_face = adjacency.begin(faces[i + j]);
+            std::uint32_t const * end = adjacency.end(faces[i + j]);
+            for (; !is_redundant && adj_face != end; ++adj_face) {
+                std::size_t adj_face_id = *adj_face;
 
                 /* Remove only the redundant face with smaller id. */
                 if (face_id < adj_face_id) {
@@ -37,16 +41,22 @@ std::size_t remove_redundant_faces(mve::MeshInfo const & mesh_info, mve::Triangl
                         }
                     }
 
-                    redundant = identical;
+                    is_redundant = identical;
                 }
             }
         }
+        redundant[face_id] = is_redundant;
+    }
 
-        if (redundant) {
-            ++num_redundant;
-        } else {
-            new_faces.insert(new_faces.end(), faces.cbegin() + i, faces.cbegin() + i + 3);
-        }
+    std::size_t num_redundant = std::count(redundant.begin(), redundant.end(), 1);
+    if (num_redundant == 0) return 0;
+
+    mve::TriangleMesh::FaceList new_faces;
+    new_faces.reserve(faces.size() - num_redundant * 3);
+    for (std::size_t face_id = 0; face_id < num_faces; ++face_id) {
+        if (redundant[face_id]) continue;
+        std::size_t const i = face_id * 3;
+        new_faces.insert(new_faces.end(), faces.cbegin() + i, faces.cbegin() + i + 3);
     }
 
     faces.swap(new_faces);
@@ -56,7 +66,7 @@ std::size_t remove_redundant_faces(mve::MeshInfo const & mesh_info, mve::Triangl
 
 void
 prepare_mesh(mve::MeshInfo * mesh_info, mve::TriangleMesh::Ptr mesh) {
-    std::size_t num_redundant = remove_redundant_faces(*mesh_info, mesh);
+    std::size_t num_redundant = remove_redundant_faces(mesh);
     if (num_redundant > 0) {
         std::cout << "\tRemoved " << num_redundant << " redundant faces." << std::endl;
     }
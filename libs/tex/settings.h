@@ -14,6 +14,8 @@
 #include <vector>
 #include <string>
 
+#include "mrf/graph.h"
+
 #include "defines.h"
 
 template <typename T>
@@ -79,6 +81,20 @@ struct Settings {
     DataTerm data_term;
     SmoothnessTerm smoothness_term;
     OutlierRemoval outlier_removal;
+    mrf::SOLVER_TYPE solver_type;
+
+    /* Stopping criteria of the optimization of each MRF (0 disables). */
+    unsigned int mrf_max_iterations;
+    float mrf_max_time;
+    float mrf_tolerance;
+    /* Number of candidate views kept per face (0 keeps all). */
+    unsigned int mrf_max_labels;
+    bool multilevel_view_selection;
+    /* Lowest data costs and majority voting instead of the MRF optimization. */
+    bool fast_view_selection;
+    /* Islands of fewer faces or with a smaller area are merged into an adjacent label (0 disables). */
+    unsigned int min_island_size;
+    float min_island_area;
 
     bool geometric_visibility_test;
     bool global_seam_leveling;
@@ -104,4 +120,13 @@ const std::vector<std::string> choice_strings<tex::OutlierRemoval>() {
     return {"none", "gauss_damping", "gauss_clamping"};
 }
 
+template <> inline
+const std::vector<std::string> choice_strings<mrf::SOLVER_TYPE>() {
+    #ifdef RESEARCH
+    return {"icm", "lbp", "expansion", "residual_lbp", "trws", "gco"};
+    #else
+    return {"icm", "lbp", "expansion", "residual_lbp", "trws"};
+    #endif
+}
+
 #endif /* TEX_SETTINGS_HEADER */
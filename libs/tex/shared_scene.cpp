@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <util/exception.h>
+
+#include "shared_scene.h"
+#include "view_manifest.h"
+
+TEX_NAMESPACE_BEGIN
+
+namespace {
+
+bool
+starts_with(std::string const & str, std::string const & prefix) {
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+SharedSceneHeader
+read_header(MappedFile const & scene) {
+    SharedSceneHeader header;
+    std::memcpy(&header, scene.get_data(), sizeof(header));
+    return header;
+}
+
+/** Checks that num elements of the given size starting at offset lie within the segment. */
+bool
+within(MappedFile const & scene, std::uint64_t offset, std::uint64_t num, std::size_t size) {
+    std::uint64_t const length = scene.get_size();
+    if (offset > length) return false;
+    return num <= (length - offset) / size;
+}
+
+}
+
+bool
+is_shared_scene(std::string const & descriptor) {
+    return starts_with(descriptor, SHARED_SCENE_SHM_PREFIX)
+        || starts_with(descriptor, SHARED_SCENE_FD_PREFIX);
+}
+
+MappedFile::Ptr
+attach_shared_scene(std::string const & descriptor) {
+    MappedFile::Ptr scene;
+
+    if (starts_with(descriptor, SHARED_SCENE_SHM_PREFIX)) {
+        std::string name = descriptor.substr(std::strlen(SHARED_SCENE_SHM_PREFIX));
+        if (name.empty() || name[0] != '/') name = "/" + name;
+
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            throw util::FileException(descriptor, std::strerror(errno));
+
+        try {
+            scene = MappedFile::create(fd, descriptor);
+        } catch (util::FileException &) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    } else if (starts_with(descriptor, SHARED_SCENE_FD_PREFIX)) {
+        std::string const number = descriptor.substr(std::strlen(SHARED_SCENE_FD_PREFIX));
+        char * end = nullptr;
+        long fd = std::strtol(number.c_str(), &end, 10);
+        if (number.empty() || *end != '\0' || fd < 0)
+            throw util::FileException(descriptor, "Invalid file descriptor!");
+
+        /* The descriptor belongs to the upstream process and stays open. */
+        scene = MappedFile::create(static_cast<int>(fd), descriptor);
+    } else {
+        throw util::FileException(descriptor, "Not a shared scene!");
+    }
+
+    if (scene->get_size() < sizeof(SharedSceneHeader))
+        throw util::FileException(descriptor, "Not a shared scene!");
+
+    SharedSceneHeader header = read_header(*scene);
+    if (std::strncmp(header.magic, SHARED_SCENE_MAGIC, sizeof(header.magic)) != 0)
+        throw util::FileException(descriptor, "Not a shared scene!");
+
+    if (header.version != SHARED_SCENE_VERSION)
+        throw util::FileException(descriptor, "Incompatible version of shared scene!");
+
+    return scene;
+}
+
+mve::TriangleMesh::Ptr
+load_shared_mesh(MappedFile const & scene) {
+    SharedSceneHeader header = read_header(scene);
+
+    if (!within(scene, header.vertex_offset, header.num_vertices, 3 * sizeof(float))
+        || !within(scene, header.face_offset, header.num_faces, 3 * sizeof(std::uint32_t)))
+        throw util::FileException("shared scene", "Mesh exceeds the segment!");
+
+    mve::TriangleMesh::Ptr mesh = mve::TriangleMesh::create();
+    mve::TriangleMesh::VertexList & vertices = mesh->get_vertices();
+    mve::TriangleMesh::FaceList & faces = mesh->get_faces();
+    vertices.resize(header.num_vertices);
+    faces.resize(header.num_faces * 3);
+
+    /* TriangleMesh owns its vectors - this is the only copy of the data. */
+    char const * vertex_block = scene.get_data() + header.vertex_offset;
+    if (header.num_vertices != 0)
+        std::memcpy(vertices[0].begin(), vertex_block, header.num_vertices * 3 * sizeof(float));
+
+    char const * face_block = scene.get_data() + header.face_offset;
+    std::int64_t const num_indices = faces.size();
+    bool valid = true;
+    #pragma omp parallel for reduction(&&:valid)
+    for (std::int64_t i = 0; i < num_indices; ++i) {
+        std::uint32_t index;
+        std::memcpy(&index, face_block + i * sizeof(index), sizeof(index));
+        valid = valid && index < header.num_vertices;
+        faces[i] = index;
+    }
+
+    if (!valid)
+        throw util::FileException("shared scene", "Face references nonexistent vertex!");
+
+    return mesh;
+}
+
+void
+load_shared_views(MappedFile const & scene, std::vector<TextureView> * texture_views) {
+    SharedSceneHeader header = read_header(scene);
+
+    if (header.view_offset > scene.get_size())
+        throw util::FileException("shared scene", "Views exceed the segment!");
+
+    char const * begin = scene.get_data() + header.view_offset;
+    char const * end = scene.get_data() + scene.get_size();
+
+    std::vector<TextureView> views;
+    parse_view_manifest_entries(begin, end, header.num_views, "shared scene", &views);
+    texture_views->swap(views);
+}
+
+TEX_NAMESPACE_END
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TEX_SHAREDSCENE_HEADER
+#define TEX_SHAREDSCENE_HEADER
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <mve/mesh.h>
+
+#include "defines.h"
+#include "mapped_file.h"
+#include "texture_view.h"
+
+#define SHARED_SCENE_MAGIC "TEXSHM"
+#define SHARED_SCENE_VERSION 1
+#define SHARED_SCENE_SHM_PREFIX "shm:"
+#define SHARED_SCENE_FD_PREFIX "fd:"
+
+TEX_NAMESPACE_BEGIN
+
+/**
+  * Header of a shared scene, which allows an upstream process to hand over
+  * mesh and cameras through a POSIX shared memory object (shm:NAME) or an
+  * inherited file descriptor, e.g. a memfd (fd:N), instead of files.
+  *
+  * All values are stored in native (little endian) byte order, all offsets
+  * are in bytes relative to the start of the segment:
+  *  - vertex block: num_vertices * 3 float (x, y, z)
+  *  - face block: num_faces * 3 uint32 (vertex indices)
+  *  - view block: num_views ViewManifestEntry records (see view_manifest.h),
+  *    each directly followed by its image path
+  */
+struct SharedSceneHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t num_vertices;
+    std::uint64_t vertex_offset;
+    std::uint64_t num_faces;
+    std::uint64_t face_offset;
+    std::uint64_t num_views;
+    std::uint64_t view_offset;
+};
+
+/** Returns true if the given descriptor refers to a shared scene. */
+bool
+is_shared_scene(std::string const & descriptor);
+
+/**
+  * Maps the shared scene referred to by the given descriptor and checks its header.
+  * @throws util::FileException
+  */
+MappedFile::Ptr
+attach_shared_scene(std::string const & descriptor);
+
+/**
+  * Creates a mesh from the vertex and face block of the shared scene.
+  * @throws util::FileException if the blocks exceed the segment.
+  */
+mve::TriangleMesh::Ptr
+load_shared_mesh(MappedFile const & scene);
+
+/**
+  * Creates the texture views from the view block of the shared scene.
+  * @throws util::FileException if the block exceeds the segment.
+  */
+void
+load_shared_views(MappedFile const & scene, std::vector<TextureView> * texture_views);
+
+TEX_NAMESPACE_END
+
+#endif /* TEX_SHAREDSCENE_HEADER */
@@ -21,7 +21,7 @@
 #include "util/exception.h"
 
 #define HEADER "SPT"
-#define VERSION "0.2"
+#define VERSION "0.3"
 
 /**
   * Class representing a sparse table optimized for row and column wise access.
@@ -8,10 +8,17 @@
  */
 
 #include <list>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+
+#include <unistd.h>
 
 #include <math/matrix.h>
 #include <mve/image_io.h>
 #include <mve/image_tools.h>
+#include <util/file_system.h>
 
 #include "texture_view.h"
 
@@ -19,7 +26,7 @@ TEX_NAMESPACE_BEGIN
 
 TextureView::TextureView(std::size_t id, mve::CameraInfo const & camera,
     std::string const & image_file)
-    : id(id), image_file(image_file) {
+    : id(id), camera(camera), image_file(image_file), cache_verified(false) {
 
     mve::image::ImageHeaders header;
     try {
@@ -33,6 +40,18 @@ TextureView::TextureView(std::size_t id, mve::CameraInfo const & camera,
     width = header.width;
     height = header.height;
 
+    initialize_camera();
+}
+
+TextureView::TextureView(std::size_t id, mve::CameraInfo const & camera,
+    std::string const & image_file, int width, int height)
+    : id(id), camera(camera), width(width), height(height), image_file(image_file),
+    cache_verified(false) {
+    initialize_camera();
+}
+
+void
+TextureView::initialize_camera(void) {
     camera.fill_calibration(*projection, width, height);
     camera.fill_camera_pos(*pos);
     camera.fill_viewing_direction(*viewdir);
@@ -93,10 +112,152 @@ TextureView::generate_validity_mask(void) {
     }
 }
 
+MappedFile::Ptr
+TextureView::map_cache_file(ViewCacheHeader * header) {
+    if (cache_file.empty() || !util::fs::file_exists(cache_file.c_str())) return NULL;
+
+    MappedFile::Ptr file;
+    try {
+        file = MappedFile::create(cache_file);
+    } catch (util::FileException & e) {
+        return NULL;
+    }
+
+    if (file->get_size() < sizeof(ViewCacheHeader)) return NULL;
+    std::memcpy(header, file->get_data(), sizeof(ViewCacheHeader));
+
+    if (std::strncmp(header->magic, VIEW_CACHE_MAGIC, sizeof(header->magic)) != 0
+        || header->version != VIEW_CACHE_VERSION
+        || header->width != width || header->height != height
+        || header->channels < 3) return NULL;
+
+    std::size_t const num_pixels = static_cast<std::size_t>(width) * height;
+    std::size_t size = sizeof(ViewCacheHeader) + num_pixels * (header->channels + 1);
+    if (header->flags & ViewCacheHeader::GRADIENT_MAGNITUDE) size += num_pixels;
+    if (file->get_size() < size) return NULL;
+
+    /* Hashing is cheap compared to decoding - verify once per run. */
+    if (!cache_verified) {
+        try {
+            if (hash_file_content(image_file) != header->content_hash) return NULL;
+        } catch (util::FileException & e) {
+            return NULL;
+        }
+        cache_verified = true;
+    }
+
+    return file;
+}
+
 void
 TextureView::load_image(void) {
     if(image != NULL) return;
-    image = mve::image::load_file(image_file);
+
+    ViewCacheHeader header;
+    MappedFile::Ptr file = map_cache_file(&header);
+    if (file != NULL) {
+        image = mve::ByteImage::create(width, height, header.channels);
+        std::memcpy(image->get_data_pointer(), file->get_data() + sizeof(ViewCacheHeader),
+            image->get_value_amount());
+        return;
+    }
+
+    /* The image is checked only here since views may stem from a view manifest. */
+    try {
+        image = mve::image::load_file(image_file);
+    } catch (util::Exception & e) {
+        std::cerr << "Could not load image " << image_file << std::endl;
+        std::cerr << e.what() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (image->width() != width || image->height() != height) {
+        std::cerr << "Image " << image_file << " does not match the dimensions of view "
+            << id << " - outdated view manifest?" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+bool
+TextureView::load_cache(bool gradient) {
+    ViewCacheHeader header;
+    MappedFile::Ptr file = map_cache_file(&header);
+    if (file == NULL) return false;
+
+    /* The validity mask is eroded iff the gradient magnitude is required. */
+    bool const has_gradient = header.flags & ViewCacheHeader::GRADIENT_MAGNITUDE;
+    bool const eroded = header.flags & ViewCacheHeader::ERODED_VALIDITY_MASK;
+    if ((gradient && !has_gradient) || eroded != gradient) return false;
+
+    std::size_t const num_pixels = static_cast<std::size_t>(width) * height;
+    char const * ptr = file->get_data() + sizeof(ViewCacheHeader);
+
+    if (image == NULL) {
+        image = mve::ByteImage::create(width, height, header.channels);
+        std::memcpy(image->get_data_pointer(), ptr, image->get_value_amount());
+    }
+    ptr += num_pixels * header.channels;
+
+    validity_mask.resize(num_pixels);
+    for (std::size_t i = 0; i < num_pixels; ++i) {
+        validity_mask[i] = ptr[i] != 0;
+    }
+    ptr += num_pixels;
+
+    if (gradient) {
+        gradient_magnitude = mve::ByteImage::create(width, height, 1);
+        std::memcpy(gradient_magnitude->get_data_pointer(), ptr, num_pixels);
+    }
+
+    return true;
+}
+
+void
+TextureView::save_cache(void) const {
+    if (cache_file.empty()) return;
+
+    assert(image != NULL);
+    assert(validity_mask.size() == static_cast<std::size_t>(width * height));
+
+    ViewCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::strncpy(header.magic, VIEW_CACHE_MAGIC, sizeof(header.magic));
+    header.version = VIEW_CACHE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.channels = image->channels();
+    header.content_hash = hash_file_content(image_file);
+    if (gradient_magnitude != NULL) {
+        header.flags = ViewCacheHeader::GRADIENT_MAGNITUDE
+            | ViewCacheHeader::ERODED_VALIDITY_MASK;
+    }
+
+    std::vector<std::uint8_t> mask(validity_mask.size());
+    for (std::size_t i = 0; i < validity_mask.size(); ++i) {
+        mask[i] = validity_mask[i] ? 255 : 0;
+    }
+
+    /* Write to a temporary file and rename to never expose partial files. */
+    std::string const tmp_file = cache_file + "." + std::to_string(::getpid())
+        + "_" + std::to_string(id) + ".tmp";
+    std::ofstream out(tmp_file.c_str(), std::ios::binary);
+    if (!out.good())
+        throw util::FileException(tmp_file, std::strerror(errno));
+
+    out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    out.write(reinterpret_cast<char const *>(image->get_data_pointer()),
+        image->get_value_amount());
+    out.write(reinterpret_cast<char const *>(mask.data()), mask.size());
+    if (gradient_magnitude != NULL) {
+        out.write(reinterpret_cast<char const *>(gradient_magnitude->get_data_pointer()),
+            gradient_magnitude->get_value_amount());
+    }
+    out.close();
+
+    if (!out.good() || std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+        std::remove(tmp_file.c_str());
+        throw util::FileException(cache_file, std::strerror(errno));
+    }
 }
 
 void
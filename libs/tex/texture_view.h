@@ -19,6 +19,8 @@
 
 #include "tri.h"
 #include "settings.h"
+#include "mapped_file.h"
+#include "view_cache.h"
 
 TEX_NAMESPACE_BEGIN
 
@@ -39,6 +41,7 @@ struct FaceProjectionInfo {
 class TextureView {
     private:
         std::size_t id;
+        mve::CameraInfo camera;
 
         math::Vec3f pos;
         math::Vec3f viewdir;
@@ -47,10 +50,16 @@ class TextureView {
         int width;
         int height;
         std::string image_file;
+        std::string cache_file;
+        bool cache_verified;
         mve::ByteImage::Ptr image;
         mve::ByteImage::Ptr gradient_magnitude;
         std::vector<bool> validity_mask;
 
+        /** Derives the projection and pose from the camera and image dimensions. */
+        void initialize_camera(void);
+        /** Maps the cache file, returns NULL if it is not a valid cache file for this view. */
+        MappedFile::Ptr map_cache_file(ViewCacheHeader * header);
 
     public:
         /** Returns the id of the TexureView which is consistent for every run. */
@@ -75,6 +84,13 @@ class TextureView {
 
         /** Constructs a TextureView from the give mve::CameraInfo containing the given image. */
         TextureView(std::size_t id, mve::CameraInfo const & camera, std::string const & image_file);
+        /** Constructs a TextureView from the give mve::CameraInfo containing the given image
+          * with known dimensions - the image file is not accessed. */
+        TextureView(std::size_t id, mve::CameraInfo const & camera, std::string const & image_file,
+            int width, int height);
+
+        /** Returns the camera. */
+        mve::CameraInfo const & get_camera(void) const;
 
         /** Returns the position. */
         math::Vec3f get_pos(void) const;
@@ -86,6 +102,11 @@ class TextureView {
         int get_height(void) const;
         /** Returns a reference pointer to the corresponding image. */
         mve::ByteImage::Ptr get_image(void) const;
+        /** Returns the path of the corresponding image. */
+        std::string const & get_image_file(void) const;
+
+        /** Sets the file which caches the preprocessed image data of this view. */
+        void set_cache_file(std::string const & filename);
 
         /** Exchange encapsulated image. */
         void bind_image(mve::ByteImage::Ptr new_image);
@@ -97,6 +118,16 @@ class TextureView {
         /** Generates the gradient magnitude image for the encapsulated image. */
         void generate_gradient_magnitude(void);
 
+        /** Loads image, validity mask and, if requested, gradient magnitude and
+          * eroded validity mask from the cache file.
+          * Returns false if no cache file is set or it does not contain these.
+          */
+        bool load_cache(bool gradient_magnitude);
+        /** Writes image, validity mask and gradient magnitude (if generated) to the cache file.
+          * Does nothing if no cache file is set.
+          */
+        void save_cache(void) const;
+
         /** Releases the validity mask. */
         void release_validity_mask(void);
         /** Releases the gradient magnitude image. */
@@ -124,6 +155,11 @@ TextureView::get_id(void) const {
     return id;
 }
 
+inline mve::CameraInfo const &
+TextureView::get_camera(void) const {
+    return camera;
+}
+
 inline math::Vec3f
 TextureView::get_pos(void) const {
     return pos;
@@ -150,6 +186,17 @@ TextureView::get_image(void) const {
     return image;
 }
 
+inline std::string const &
+TextureView::get_image_file(void) const {
+    return image_file;
+}
+
+inline void
+TextureView::set_cache_file(std::string const & filename) {
+    cache_file = filename;
+    cache_verified = false;
+}
+
 inline bool
 TextureView::inside(math::Vec3f const & v1, math::Vec3f const & v2, math::Vec3f const & v3) const {
     math::Vec2f p1 = get_pixel_coords(v1);
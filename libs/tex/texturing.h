@@ -10,6 +10,10 @@
 #ifndef TEX_TEXTURING_HEADER
 #define TEX_TEXTURING_HEADER
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
 #include "mve/mesh.h"
@@ -35,10 +39,47 @@ typedef std::vector<TexturePatch::Ptr> TexturePatches;
 typedef std::vector<TextureAtlas::Ptr> TextureAtlases;
 typedef ObjModel Model;
 typedef UniGraph Graph;
-typedef SparseTable<std::uint32_t, std::uint16_t, float> DataCosts;
+/* Data costs are quantized to 16 bit, the maximum corresponds to MRF_MAX_ENERGYTERM. */
+typedef std::uint16_t DataCost;
+typedef SparseTable<std::uint32_t, std::uint16_t, DataCost> DataCosts;
 typedef std::vector<std::vector<VertexProjectionInfo> > VertexProjectionInfos;
 typedef std::vector<std::vector<FaceProjectionInfo> > FaceProjectionInfos;
 
+/** Quantizes a data cost given in [0, 1]. */
+inline DataCost
+quantize_data_cost(float cost) {
+    float const max_cost = std::numeric_limits<DataCost>::max();
+    return static_cast<DataCost>(std::min(std::max(cost, 0.0f), 1.0f) * max_cost + 0.5f);
+}
+
+/**
+  * Returns the data cost within the energy of the view selection MRF.
+  * Both are stored with 16 bit, the quantized cost is used as is.
+  */
+inline mrf::DATA_COST_TYPE
+mrf_data_cost(DataCost cost) {
+    static_assert(std::numeric_limits<DataCost>::max() == MRF_MAX_ENERGYTERM,
+        "Data costs have to match the MRF data costs");
+    return cost;
+}
+
+/** Energy of a view selection MRF after an iteration. */
+struct MRFEnergy {
+    std::size_t mrf;
+    unsigned int iteration;
+    float energy;
+    float seconds;
+};
+typedef std::vector<MRFEnergy> MRFEnergyTrace;
+
+/**
+  * Loads the mesh from the given ply file. Binary little endian triangle meshes
+  * are memory mapped and parsed in parallel, other files are loaded with mve.
+  * @throws util::Exception
+  */
+mve::TriangleMesh::Ptr
+load_mesh(std::string const & filename);
+
 /**
   * prepares the mesh for texturing
   *  -removes duplicated faces
@@ -54,11 +95,19 @@ void
 generate_texture_views(std::string const & in_scene, TextureViews * texture_views);
 
 /**
-  * Builds up the meshes face adjacency graph using the vertex_infos
+  * Assigns each TextureView a file within cache_dir, keyed by path, size and mtime of
+  * its image and the data term, in which the decoded image, validity mask and
+  * gradient magnitude are cached across runs.
   */
 void
-build_adjacency_graph(mve::TriangleMesh::ConstPtr mesh,
-    mve::MeshInfo const & mesh_info, UniGraph * graph);
+setup_view_cache(std::string const & cache_dir, Settings const & settings,
+    TextureViews * texture_views);
+
+/**
+  * Builds up the meshes face adjacency graph (faces sharing an edge), see FaceGraph.
+  */
+void
+build_adjacency_graph(mve::TriangleMesh::ConstPtr mesh, UniGraph * graph);
 
 /**
  * Calculates the data costs for each face and texture view combination,
@@ -75,10 +124,28 @@ postprocess_face_infos(Settings const & settings,
     DataCosts * data_costs);
 
 /**
- * Runs the view selection procedure and saves the labeling in the graph
+ * Runs the view selection procedure and saves the labeling in the graph.
+ * If trace is given, the energy of each MRF after each iteration is appended to it.
+ * If initial_labeling is given (one label per face, 0 for none), the optimization
+ * starts from it instead of from the lowest data costs.
+ * With settings.fast_view_selection no MRF is optimized: each face gets its
+ * lowest cost view, followed by a few sweeps of neighborhood majority voting.
+ * Afterwards islands of less than settings.min_island_size faces, or with an area
+ * below settings.min_island_area (requires the area of each face in face_areas),
+ * are relabeled to an adjacent label in which they are seen.
+ */
+void
+view_selection(DataCosts const & data_costs, UniGraph * graph, Settings const & settings,
+    MRFEnergyTrace * trace = nullptr,
+    std::vector<std::size_t> const * initial_labeling = nullptr,
+    std::vector<float> const * face_areas = nullptr);
+
+/**
+ * Writes the energy trace of the view selection as csv file.
+ * @throws util::FileException
  */
 void
-view_selection(DataCosts const & data_costs, UniGraph * graph, Settings const & settings);
+save_mrf_energies(std::string const & filename, MRFEnergyTrace const & trace);
 
 /**
   * Generates texture patches using the graph to determine adjacent faces with the same label.
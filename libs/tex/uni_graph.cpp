@@ -7,6 +7,7 @@
  * of the BSD 3-Clause license. See the LICENSE.txt file for details.
  */
 
+#include <atomic>
 #include <limits>
 #include <list>
 
@@ -53,3 +54,86 @@ UniGraph::get_subgraphs(std::size_t label,
         }
     }
 }
+
+namespace {
+
+/** Returns the root of the given node's set, halving the path on the way. */
+std::size_t
+find_root(std::vector<std::atomic<std::size_t> > * parents, std::size_t node) {
+    std::size_t parent = (*parents)[node].load(std::memory_order_relaxed);
+    while (parent != node) {
+        std::size_t grandparent = (*parents)[parent].load(std::memory_order_relaxed);
+        /* Failing is harmless - another thread has already shortened the path. */
+        (*parents)[node].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+        node = parent;
+        parent = (*parents)[node].load(std::memory_order_relaxed);
+    }
+    return node;
+}
+
+/**
+  * Merges the sets of both nodes by linking the larger root to the smaller one,
+  * the root of each set thus remains its smallest node.
+  */
+void
+unite(std::vector<std::atomic<std::size_t> > * parents, std::size_t n1, std::size_t n2) {
+    while (true) {
+        n1 = find_root(parents, n1);
+        n2 = find_root(parents, n2);
+        if (n1 == n2) return;
+        if (n1 < n2) std::swap(n1, n2);
+        /* Retry if n1 got linked by another thread in the meantime. */
+        std::size_t expected = n1;
+        if ((*parents)[n1].compare_exchange_strong(expected, n2)) return;
+    }
+}
+
+}
+
+void
+UniGraph::get_all_subgraphs(std::vector<std::vector<std::vector<std::size_t> > > * subgraphs) const {
+    std::size_t const num_nodes = adj_lists.size();
+
+    std::vector<std::atomic<std::size_t> > parents(num_nodes);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        parents[i].store(i, std::memory_order_relaxed);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        for (std::size_t adj_node : adj_lists[i]) {
+            if (i < adj_node && labels[i] == labels[adj_node]) {
+                unite(&parents, i, adj_node);
+            }
+        }
+    }
+
+    std::vector<std::size_t> roots(num_nodes);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        roots[i] = find_root(&parents, i);
+    }
+
+    /* Roots are the smallest nodes of their subgraphs - number the subgraphs
+     * of each label in the order of their roots and count their sizes. */
+    std::size_t num_labels = 0;
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        num_labels = std::max(num_labels, labels[i] + 1);
+    }
+    subgraphs->clear();
+    subgraphs->resize(num_labels);
+
+    std::vector<std::size_t> ids(num_nodes);
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        if (roots[i] == i) {
+            std::vector<std::vector<std::size_t> > & label_subgraphs = subgraphs->at(labels[i]);
+            ids[i] = label_subgraphs.size();
+            label_subgraphs.push_back(std::vector<std::size_t>());
+        }
+    }
+
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        subgraphs->at(labels[i])[ids[roots[i]]].push_back(i);
+    }
+}
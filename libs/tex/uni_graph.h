@@ -74,6 +74,14 @@ class UniGraph {
           */
         void get_subgraphs(std::size_t label, std::vector<std::vector<std::size_t> > * subgraphs) const;
 
+        /**
+          * Fills given vector with the subgraphs of all labels in a single pass,
+          * subgraphs->at(label) holds the subgraphs of the label (ordered by their smallest node).
+          * The connected components are determined with a parallel union-find over all edges
+          * between nodes with the same label.
+          */
+        void get_all_subgraphs(std::vector<std::vector<std::vector<std::size_t> > > * subgraphs) const;
+
         std::vector<std::size_t> const & get_adj_nodes(std::size_t node) const;
 };
 
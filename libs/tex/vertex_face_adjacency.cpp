@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "vertex_face_adjacency.h"
+
+TEX_NAMESPACE_BEGIN
+
+VertexFaceAdjacency::VertexFaceAdjacency(mve::TriangleMesh::ConstPtr mesh) {
+    mve::TriangleMesh::FaceList const & mesh_faces = mesh->get_faces();
+    std::size_t const num_vertices = mesh->get_vertices().size();
+    std::size_t const num_corners = mesh_faces.size();
+
+    /* Count the faces of each vertex. */
+    std::unique_ptr<std::atomic<std::uint32_t>[]> counts(
+        new std::atomic<std::uint32_t>[num_vertices]);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_corners; ++i) {
+        counts[mesh_faces[i]].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /* Exclusive prefix sum yields the bucket offsets. */
+    offsets.resize(num_vertices + 1);
+    offsets[0] = 0;
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        offsets[i + 1] = offsets[i] + counts[i].load(std::memory_order_relaxed);
+    }
+
+    /* Scatter the faces into the buckets, reusing the counts as cursors. */
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    faces.resize(num_corners);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_corners; ++i) {
+        std::size_t const vertex = mesh_faces[i];
+        std::uint32_t const pos = counts[vertex].fetch_add(1, std::memory_order_relaxed);
+        faces[offsets[vertex] + pos] = static_cast<std::uint32_t>(i / 3);
+    }
+
+    /* The scatter order depends on thread timing - sort each bucket. */
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        std::sort(faces.begin() + offsets[i], faces.begin() + offsets[i + 1]);
+    }
+}
+
+TEX_NAMESPACE_END
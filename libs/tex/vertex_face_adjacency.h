@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TEX_VERTEXFACEADJACENCY_HEADER
+#define TEX_VERTEXFACEADJACENCY_HEADER
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <mve/mesh.h>
+
+#include "defines.h"
+
+TEX_NAMESPACE_BEGIN
+
+/**
+  * Class representing the faces adjacent to each vertex of a triangle mesh in
+  * compressed row storage. The faces of a vertex are sorted by id.
+  */
+class VertexFaceAdjacency {
+    private:
+        std::vector<std::size_t> offsets;
+        std::vector<std::uint32_t> faces;
+
+    public:
+        /** Builds the adjacency with a parallel counting sort of the face corners. */
+        VertexFaceAdjacency(mve::TriangleMesh::ConstPtr mesh);
+
+        /** Returns the number of vertices. */
+        std::size_t num_vertices(void) const;
+
+        /** Returns the number of faces adjacent to the given vertex. */
+        std::size_t num_faces(std::size_t vertex) const;
+
+        /** Returns a pointer to the first face adjacent to the given vertex. */
+        std::uint32_t const * begin(std::size_t vertex) const;
+        /** Returns a pointer behind the last face adjacent to the given vertex. */
+        std::uint32_t const * end(std::size_t vertex) const;
+};
+
+inline std::size_t
+VertexFaceAdjacency::num_vertices(void) const {
+    return offsets.size() - 1;
+}
+
+inline std::size_t
+VertexFaceAdjacency::num_faces(std::size_t vertex) const {
+    assert(vertex < num_vertices());
+    return offsets[vertex + 1] - offsets[vertex];
+}
+
+inline std::uint32_t const *
+VertexFaceAdjacency::begin(std::size_t vertex) const {
+    assert(vertex < num_vertices());
+    return faces.data() + offsets[vertex];
+}
+
+inline std::uint32_t const *
+VertexFaceAdjacency::end(std::size_t vertex) const {
+    assert(vertex < num_vertices());
+    return faces.data() + offsets[vertex + 1];
+}
+
+TEX_NAMESPACE_END
+
+#endif /* TEX_VERTEXFACEADJACENCY_HEADER */
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/stat.h>
+
+#include <util/file_system.h>
+
+#include "mapped_file.h"
+#include "texturing.h"
+#include "view_cache.h"
+
+TEX_NAMESPACE_BEGIN
+
+namespace {
+
+std::uint64_t
+fnv1a(char const * data, std::size_t size,
+    std::uint64_t hash = 14695981039346656037ull) {
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}
+
+std::uint64_t
+hash_file_content(std::string const & filename) {
+    MappedFile file(filename);
+    return fnv1a(file.get_data(), file.get_size());
+}
+
+std::string
+view_cache_file(std::string const & cache_dir, std::string const & image_file,
+    DataTerm data_term) {
+
+    struct stat info;
+    if (::stat(image_file.c_str(), &info) != 0)
+        throw util::FileException(image_file, std::strerror(errno));
+
+    std::string const path = util::fs::abspath(image_file);
+    std::uint64_t const size = info.st_size;
+    std::int64_t const mtime = info.st_mtime;
+    std::uint64_t key = fnv1a(path.data(), path.size());
+    key = fnv1a(reinterpret_cast<char const *>(&size), sizeof(size), key);
+    key = fnv1a(reinterpret_cast<char const *>(&mtime), sizeof(mtime), key);
+
+    /* The validity mask differs between the data terms (eroded for GMI). */
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key
+        << (data_term == GMI ? "_gmi" : "_area") << VIEW_CACHE_EXTENSION;
+    return util::fs::join_path(cache_dir, ss.str());
+}
+
+void
+setup_view_cache(std::string const & cache_dir, Settings const & settings,
+    TextureViews * texture_views) {
+
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < texture_views->size(); ++i) {
+        TextureView * texture_view = &texture_views->at(i);
+        try {
+            texture_view->set_cache_file(view_cache_file(cache_dir,
+                texture_view->get_image_file(), settings.data_term));
+        } catch (util::FileException & e) {
+            #pragma omp critical
+            std::cerr << "\tCould not set up view cache: " << e.what() << std::endl;
+        }
+    }
+}
+
+TEX_NAMESPACE_END
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TEX_VIEWCACHE_HEADER
+#define TEX_VIEWCACHE_HEADER
+
+#include <cstdint>
+#include <string>
+
+#include "defines.h"
+#include "settings.h"
+
+#define VIEW_CACHE_MAGIC "TVC"
+#define VIEW_CACHE_VERSION 2
+#define VIEW_CACHE_EXTENSION ".tvc"
+
+TEX_NAMESPACE_BEGIN
+
+/**
+  * Header of a view cache file.
+  * The content hash of the image the cache file has been created from guards
+  * against images which have been replaced without changing size and mtime.
+  * The header is followed by raw, tightly packed and uncompressed blocks
+  * which can be used directly from a memory mapping:
+  *  - the image (width * height * channels bytes, interleaved)
+  *  - the validity mask (width * height bytes, 0 or 255)
+  *  - the gradient magnitude (width * height bytes), if flags & GRADIENT_MAGNITUDE
+  */
+struct ViewCacheHeader {
+    enum Flags {
+        /** The gradient magnitude block is present. */
+        GRADIENT_MAGNITUDE = 1 << 0,
+        /** The validity mask has been eroded. */
+        ERODED_VALIDITY_MASK = 1 << 1
+    };
+
+    char magic[4];
+    std::uint32_t version;
+    std::int32_t width;
+    std::int32_t height;
+    std::int32_t channels;
+    std::uint32_t flags;
+    std::uint64_t content_hash;
+};
+
+/** Returns the 64bit FNV-1a hash of the content of the file given by filename.
+  * @throws util::FileException
+  */
+std::uint64_t
+hash_file_content(std::string const & filename);
+
+/**
+  * Returns the path of the cache file for the given image and data term within cache_dir.
+  * The file name is keyed by the path, size and modification time of the image.
+  * @throws util::FileException if the image does not exist.
+  */
+std::string
+view_cache_file(std::string const & cache_dir, std::string const & image_file,
+    DataTerm data_term);
+
+TEX_NAMESPACE_END
+
+#endif /* TEX_VIEWCACHE_HEADER */
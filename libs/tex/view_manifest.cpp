@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+#include <util/exception.h>
+#include <util/file_system.h>
+#include <util/tokenizer.h>
+
+#include "view_manifest.h"
+
+TEX_NAMESPACE_BEGIN
+
+namespace {
+
+/** Size and modification time of a file the texture views are created from. */
+struct SceneFileStamp {
+    std::string path;
+    std::uint64_t size;
+    std::int64_t mtime;
+
+    bool operator==(SceneFileStamp const & other) const {
+        return path == other.path && size == other.size && mtime == other.mtime;
+    }
+};
+
+void
+add_scene_file_stamp(std::string const & path, std::vector<SceneFileStamp> * stamps) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) return;
+    stamps->push_back({path, static_cast<std::uint64_t>(info.st_size),
+        static_cast<std::int64_t>(info.st_mtime)});
+}
+
+/**
+  * Returns the stamps the scene descriptor is validated with (see
+  * generate_texture_views): the bundle file, the scene folder or the views
+  * directory of a MVE scene. Adding or removing views changes the modification
+  * time of the directory - the individual files are not accessed, the images
+  * are checked when they are opened (see TextureView::load_image).
+  */
+std::vector<SceneFileStamp>
+scene_file_stamps(std::string const & in_scene) {
+    std::vector<SceneFileStamp> stamps;
+
+    util::Tokenizer tok;
+    tok.split(in_scene, ':', true);
+
+    /* BUNDLEFILE or SCENE_FOLDER */
+    if (tok.size() == 1) {
+        add_scene_file_stamp(tok[0], &stamps);
+    }
+
+    /* MVE_SCENE::EMBEDDING */
+    std::size_t pos = in_scene.rfind("::");
+    if (pos != std::string::npos) {
+        add_scene_file_stamp(util::fs::join_path(in_scene.substr(0, pos), "views"), &stamps);
+    }
+
+    return stamps;
+}
+
+}
+
+ViewManifestEntry
+make_manifest_entry(TextureView const & texture_view) {
+    mve::CameraInfo const & camera = texture_view.get_camera();
+
+    ViewManifestEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    entry.id = texture_view.get_id();
+    entry.width = texture_view.get_width();
+    entry.height = texture_view.get_height();
+    entry.flen = camera.flen;
+    entry.paspect = camera.paspect;
+    std::copy(camera.ppoint, camera.ppoint + 2, entry.ppoint);
+    std::copy(camera.dist, camera.dist + 2, entry.dist);
+    std::copy(camera.trans, camera.trans + 3, entry.trans);
+    std::copy(camera.rot, camera.rot + 9, entry.rot);
+    entry.image_file_length = texture_view.get_image_file().size();
+    return entry;
+}
+
+mve::CameraInfo
+manifest_entry_camera(ViewManifestEntry const & entry) {
+    mve::CameraInfo camera;
+    camera.flen = entry.flen;
+    camera.paspect = entry.paspect;
+    std::copy(entry.ppoint, entry.ppoint + 2, camera.ppoint);
+    std::copy(entry.dist, entry.dist + 2, camera.dist);
+    std::copy(entry.trans, entry.trans + 3, camera.trans);
+    std::copy(entry.rot, entry.rot + 9, camera.rot);
+    return camera;
+}
+
+void
+save_view_manifest(std::string const & filename, std::string const & in_scene,
+    std::vector<TextureView> const & texture_views) {
+
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if (!out.good())
+        throw util::FileException(filename, std::strerror(errno));
+
+    std::vector<SceneFileStamp> const stamps = scene_file_stamps(in_scene);
+
+    out << VIEW_MANIFEST_HEADER << " " << VIEW_MANIFEST_VERSION << " "
+        << texture_views.size() << " " << in_scene.size() << " " << stamps.size() << std::endl;
+    out.write(in_scene.data(), in_scene.size());
+
+    for (SceneFileStamp const & stamp : stamps) {
+        std::uint32_t const path_length = stamp.path.size();
+        out.write(reinterpret_cast<char const *>(&stamp.size), sizeof(stamp.size));
+        out.write(reinterpret_cast<char const *>(&stamp.mtime), sizeof(stamp.mtime));
+        out.write(reinterpret_cast<char const *>(&path_length), sizeof(path_length));
+        out.write(stamp.path.data(), path_length);
+    }
+
+    for (TextureView const & texture_view : texture_views) {
+        ViewManifestEntry entry = make_manifest_entry(texture_view);
+        std::string const & image_file = texture_view.get_image_file();
+        out.write(reinterpret_cast<char const *>(&entry), sizeof(entry));
+        out.write(image_file.data(), image_file.size());
+    }
+
+    out.close();
+    if (!out.good())
+        throw util::FileException(filename, std::strerror(errno));
+}
+
+void
+parse_view_manifest_entries(char const * begin, char const * end, std::size_t num_views,
+    std::string const & name, std::vector<TextureView> * texture_views) {
+
+    char const * ptr = begin;
+    texture_views->reserve(texture_views->size() + num_views);
+    for (std::size_t i = 0; i < num_views; ++i) {
+        ViewManifestEntry entry;
+        if (static_cast<std::size_t>(end - ptr) < sizeof(entry))
+            throw util::FileException(name, "Truncated view records!");
+        std::memcpy(&entry, ptr, sizeof(entry));
+        ptr += sizeof(entry);
+
+        if (static_cast<std::size_t>(end - ptr) < entry.image_file_length)
+            throw util::FileException(name, "Truncated view records!");
+        std::string image_file(ptr, entry.image_file_length);
+        ptr += entry.image_file_length;
+
+        texture_views->push_back(TextureView(entry.id, manifest_entry_camera(entry),
+            image_file, entry.width, entry.height));
+    }
+}
+
+void
+load_view_manifest(std::string const & filename, std::string const & in_scene,
+    std::vector<TextureView> * texture_views) {
+
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in.good())
+        throw util::FileException(filename, std::strerror(errno));
+
+    /* Read the whole manifest at once. */
+    in.seekg(0, in.end);
+    std::size_t const filesize = in.tellg();
+    in.seekg(0, in.beg);
+    std::vector<char> buffer(filesize);
+    in.read(buffer.data(), filesize);
+    in.close();
+
+    char const * const begin = buffer.data();
+    char const * const end = begin + buffer.size();
+    char const * ptr = std::find(begin, end, '\n');
+    if (ptr == end)
+        throw util::FileException(filename, "Not a view manifest file!");
+
+    std::stringstream ss(std::string(begin, ptr++));
+    std::string header, version;
+    std::size_t num_views = 0, scene_length = 0, num_stamps = 0;
+    ss >> header >> version >> num_views >> scene_length >> num_stamps;
+
+    if (header != VIEW_MANIFEST_HEADER)
+        throw util::FileException(filename, "Not a view manifest file!");
+
+    if (version != VIEW_MANIFEST_VERSION)
+        throw util::FileException(filename, "Incompatible version of view manifest file!");
+
+    if (static_cast<std::size_t>(end - ptr) < scene_length
+        || std::string(ptr, scene_length) != in_scene)
+        throw util::FileException(filename, "View manifest belongs to a different scene!");
+    ptr += scene_length;
+
+    std::vector<SceneFileStamp> stamps(num_stamps);
+    for (SceneFileStamp & stamp : stamps) {
+        std::uint32_t path_length = 0;
+        std::size_t const record_size = sizeof(stamp.size) + sizeof(stamp.mtime) + sizeof(path_length);
+        if (static_cast<std::size_t>(end - ptr) < record_size)
+            throw util::FileException(filename, "Truncated scene file records!");
+        std::memcpy(&stamp.size, ptr, sizeof(stamp.size));
+        ptr += sizeof(stamp.size);
+        std::memcpy(&stamp.mtime, ptr, sizeof(stamp.mtime));
+        ptr += sizeof(stamp.mtime);
+        std::memcpy(&path_length, ptr, sizeof(path_length));
+        ptr += sizeof(path_length);
+
+        if (static_cast<std::size_t>(end - ptr) < path_length)
+            throw util::FileException(filename, "Truncated scene file records!");
+        stamp.path.assign(ptr, path_length);
+        ptr += path_length;
+    }
+
+    if (stamps != scene_file_stamps(in_scene))
+        throw util::FileException(filename, "Scene has changed since the view manifest was written!");
+
+    std::vector<TextureView> views;
+    parse_view_manifest_entries(ptr, end, num_views, filename, &views);
+    texture_views->swap(views);
+}
+
+TEX_NAMESPACE_END
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TEX_VIEWMANIFEST_HEADER
+#define TEX_VIEWMANIFEST_HEADER
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <mve/camera.h>
+
+#include "defines.h"
+#include "texture_view.h"
+
+#define VIEW_MANIFEST_HEADER "TVM"
+#define VIEW_MANIFEST_VERSION "0.3"
+
+TEX_NAMESPACE_BEGIN
+
+/**
+  * Binary record describing a TextureView without the need to access its image.
+  * Within a manifest file each record is directly followed by the image path
+  * (image_file_length bytes, not null terminated).
+  */
+struct ViewManifestEntry {
+    std::uint64_t id;
+    std::int32_t width;
+    std::int32_t height;
+    float flen;
+    float paspect;
+    float ppoint[2];
+    float dist[2];
+    float trans[3];
+    float rot[9];
+    std::uint32_t image_file_length;
+};
+
+/** Fills a ViewManifestEntry with the camera and dimensions of the given TextureView. */
+ViewManifestEntry
+make_manifest_entry(TextureView const & texture_view);
+
+/** Returns the mve::CameraInfo described by the given ViewManifestEntry. */
+mve::CameraInfo
+manifest_entry_camera(ViewManifestEntry const & entry);
+
+/**
+  * Appends num_views texture views created from the consecutive records
+  * (each followed by its image path) in [begin, end) to texture_views.
+  * @throws util::FileException (referring to name) if the records exceed the range.
+  */
+void
+parse_view_manifest_entries(char const * begin, char const * end, std::size_t num_views,
+    std::string const & name, std::vector<TextureView> * texture_views);
+
+/**
+  * Saves the cameras, image paths and image dimensions of the texture views
+  * of the given scene to the file given by filename, together with the size
+  * and modification time of the scene descriptor (bundle file, scene folder
+  * or views directory of a MVE scene).
+  * The scene descriptor and version are stored in ascii, the records in binary.
+  * @throws util::FileException
+  */
+void
+save_view_manifest(std::string const & filename, std::string const & in_scene,
+    std::vector<TextureView> const & texture_views);
+
+/**
+  * Loads the texture views from the manifest file given by filename with a single read.
+  * The images are not accessed - a missing image is reported once it is loaded.
+  * @throws util::FileException if the file does not exist, the header does not match,
+  *  the manifest has been written for a different scene or the scene descriptor
+  *  has changed since.
+  */
+void
+load_view_manifest(std::string const & filename, std::string const & in_scene,
+    std::vector<TextureView> * texture_views);
+
+TEX_NAMESPACE_END
+
+#endif /* TEX_VIEWMANIFEST_HEADER */
@@ -7,209 +7,1001 @@
  * of the BSD 3-Clause license. See the LICENSE.txt file for details.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <tuple>
+
 #include <util/timer.h>
+#include <util/exception.h>
 
 #include "util.h"
 #include "texturing.h"
+#include "face_graph.h"
+#include "partition_mesh.h"
 
 TEX_NAMESPACE_BEGIN
 
 bool IGNORE_LUMINANCE = false;
 
-/** Potts model */
-float
-potts(int, int, int l1, int l2) {
-    return l1 == l2 && l1 != 0 && l2 != 0 ? 0 : 1 * MRF_MAX_ENERGYTERM;
-}
+/* Components with more faces are split into partitions (see optimize_partitioned). */
+#define MAX_MRF_SITES 500000
+/* Number of face rings on each side of partition borders that are optimized again. */
+#define BAND_WIDTH 2
+/* Multilevel view selection: faces per superface, minimal component size and
+ * maximal number of iterations at full resolution. */
+#define SUPERFACE_SIZE 16
+#define MIN_MULTILEVEL_SITES 1000
+#define REFINEMENT_ITERATIONS 5
+/* Fast view selection: maximal number of majority voting sweeps. */
+#define MAJORITY_SWEEPS 3
 
 struct FaceInfo {
     std::size_t component;
     std::size_t id;
 };
 
-/** Setup the neighborhood of the MRF. */
+struct PartInfo {
+    std::size_t part;
+    std::size_t id;
+};
+
+/* Site index of faces outside of the MRF (see cluster_superfaces). */
+std::size_t const OUTSIDE = std::numeric_limits<std::size_t>::max();
+
+/**
+  * Returns the label (view + 1) with the lowest data cost of a face, the first one
+  * on ties, or 0 (undefined) if the face is not seen in any view.
+  */
+std::size_t
+lowest_cost_label(DataCosts::Column const & data_costs_for_face) {
+    auto lower_cost = [] (DataCosts::Column::value_type const & a,
+        DataCosts::Column::value_type const & b) -> bool {
+        return a.second < b.second;
+    };
+    auto it = std::min_element(data_costs_for_face.begin(), data_costs_for_face.end(), lower_cost);
+    return it != data_costs_for_face.end() ? it->first + 1u : 0;
+}
+
+/**
+  * Sets the neighbors and data costs of the MRF of a component in one pass
+  * (see mrf::Graph::set_graph), label 0 (undefined) is available for all faces.
+  */
 void
-set_neighbors(UniGraph const & graph, std::vector<FaceInfo> const & face_infos,
-    std::vector<mrf::Graph::Ptr> const & mrfs) {
-    for (std::size_t i = 0; i < graph.num_nodes(); ++i) {
-        std::vector<std::size_t> adj_faces = graph.get_adj_nodes(i);
+set_graph(mrf::Graph::Ptr mrf, std::vector<std::size_t> const & faces,
+    std::vector<FaceInfo> const & face_infos, FaceGraph const & graph,
+    DataCosts const & data_costs) {
+
+    std::size_t const num_faces = faces.size();
+    std::vector<std::size_t> neighbor_offsets(num_faces + 1, 0);
+    std::vector<std::size_t> cost_offsets(num_faces + 1, 0);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        neighbor_offsets[i + 1] = graph.get_adj_nodes(faces[i]).size();
+        cost_offsets[i + 1] = data_costs.col(faces[i]).size() + 1;
+    }
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        neighbor_offsets[i + 1] += neighbor_offsets[i];
+        cost_offsets[i + 1] += cost_offsets[i];
+    }
+
+    std::vector<int> neighbors(neighbor_offsets.back());
+    std::vector<int> labels(cost_offsets.back());
+    std::vector<mrf::DATA_COST_TYPE> costs(cost_offsets.back());
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        std::size_t const face = faces[i];
+        FaceGraph::AdjNodes const adj_faces = graph.get_adj_nodes(face);
         for (std::size_t j = 0; j < adj_faces.size(); ++j) {
-            std::size_t adj_face = adj_faces[j];
-            /* The solver expects only one call of setNeighbours for two neighbours a and b. */
-            if (i < adj_face) {
-                assert(face_infos[i].component == face_infos[adj_face].component);
-                const std::size_t component = face_infos[i].component;
-                const std::size_t cid1 = face_infos[i].id;
-                const std::size_t cid2 = face_infos[adj_face].id;
-                mrfs[component]->set_neighbors(cid1, cid2);
-            }
+            assert(face_infos[adj_faces[j]].component == face_infos[face].component);
+            neighbors[neighbor_offsets[i] + j] = static_cast<int>(face_infos[adj_faces[j]].id);
         }
+
+        DataCosts::Column const & data_costs_for_face = data_costs.col(face);
+        std::size_t idx = cost_offsets[i];
+        for (std::size_t j = 0; j < data_costs_for_face.size(); ++j, ++idx) {
+            labels[idx] = data_costs_for_face[j].first + 1;
+            costs[idx] = mrf_data_cost(data_costs_for_face[j].second);
+        }
+        labels[idx] = 0;
+        costs[idx] = MRF_MAX_ENERGYTERM;
     }
+
+    mrf->set_graph(neighbor_offsets, neighbors, cost_offsets, labels, costs);
 }
 
-/** Set the data costs of the MRF. */
+/**
+  * Returns the adjacency of the faces without the edges of faces
+  * which have not been seen in any texture view.
+  */
+FaceGraph
+isolate_unseen_faces(UniGraph const & graph, DataCosts const & data_costs) {
+    int num_unseen_faces = 0;
+    std::vector<bool> unseen(data_costs.cols(), false);
+    for (std::uint32_t i = 0; i < data_costs.cols(); i++) {
+        DataCosts::Column const & data_costs_for_face = data_costs.col(i);
+
+        if (data_costs_for_face.size() == 0) {
+            num_unseen_faces++;
+            unseen[i] = true;
+        }
+
+    }
+    std::cout << "\t" << num_unseen_faces << " faces have not been seen by a view." << std::endl;
+
+    return FaceGraph(graph, unseen);
+}
+
+/**
+  * Restricts the candidate labels of each face to its max_labels lowest data costs.
+  * To keep neighboring faces able to agree on a label, the best view of each
+  * adjacent face is kept as well if the face is seen in that view.
+  */
 void
-set_data_costs(std::vector<FaceInfo> const & face_infos, DataCosts const & data_costs,
-    std::vector<mrf::Graph::Ptr> const & mrfs) {
+prune_labels(DataCosts const & data_costs, FaceGraph const & graph,
+    std::size_t max_labels, DataCosts * pruned_data_costs) {
+    std::uint32_t const num_faces = data_costs.cols();
+
+    std::vector<std::uint16_t> best_views(num_faces, 0);
+    #pragma omp parallel for
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        std::size_t const label = lowest_cost_label(data_costs.col(i));
+        if (label != 0) best_views[i] = static_cast<std::uint16_t>(label - 1);
+    }
 
-    /* Set data costs for all labels except label 0 (undefined) */
-    for (std::size_t i = 0; i < data_costs.rows(); i++) {
-        DataCosts::Row const & data_costs_for_label = data_costs.row(i);
+    std::vector<DataCosts::Column> candidates(num_faces);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        DataCosts::Column const & data_costs_for_face = data_costs.col(i);
+        DataCosts::Column & face_candidates = candidates[i];
+        face_candidates = data_costs_for_face;
+        if (face_candidates.size() <= max_labels) continue;
+
+        auto lower_cost = [] (DataCosts::Column::value_type const & a,
+            DataCosts::Column::value_type const & b) -> bool {
+            return a.second < b.second;
+        };
+        std::nth_element(face_candidates.begin(), face_candidates.begin() + max_labels,
+            face_candidates.end(), lower_cost);
+        face_candidates.resize(max_labels);
+
+        for (std::size_t adj_face : graph.get_adj_nodes(i)) {
+            std::uint16_t const view = best_views[adj_face];
+            auto has_view = [view] (DataCosts::Column::value_type const & entry) -> bool {
+                return entry.first == view;
+            };
+            if (std::any_of(face_candidates.begin(), face_candidates.end(), has_view)) continue;
+            auto it = std::find_if(data_costs_for_face.begin(), data_costs_for_face.end(), has_view);
+            if (it != data_costs_for_face.end()) face_candidates.push_back(*it);
+        }
+    }
 
-        std::vector<std::vector<mrf::SparseDataCost> > costs(mrfs.size());
-        for(std::size_t j = 0; j < data_costs_for_label.size(); j++) {
-            const std::size_t id = data_costs_for_label[j].first;
-            const float data_cost = data_costs_for_label[j].second;
-            const std::size_t component = face_infos[id].component;
-            const std::size_t cid = face_infos[id].id;
-            //TODO change index type of mrf::Graph
-            costs[component].push_back({static_cast<int>(cid), data_cost});
+    *pruned_data_costs = DataCosts(num_faces, data_costs.rows());
+    for (std::uint32_t i = 0; i < num_faces; ++i) {
+        for (DataCosts::Column::value_type const & entry : candidates[i]) {
+            pruned_data_costs->set_value(i, entry.first, entry.second);
         }
+        DataCosts::Column().swap(candidates[i]);
+    }
 
-        int label = i + 1;
+    std::cout << "\tKept " << pruned_data_costs->get_nnz() << " of "
+        << data_costs.get_nnz() << " candidate labels." << std::endl;
+}
 
-        for (std::size_t j = 0; j < mrfs.size(); ++j) {
-            mrfs[j]->set_data_costs(label, costs[j]);
-        }
+/** Returns the smoothness cost function selected in the settings. */
+mrf::SmoothCostFunction
+smooth_cost_function(Settings const & settings) {
+    switch (settings.smoothness_term) {
+        case POTTS: return mrf::potts;
     }
+    return mrf::potts;
+}
+
+/**
+  * Optimizes the MRF until convergence or until one of the stopping criteria
+  * of the settings (iterations, time, relative energy decrease) is met.
+  * Appends the energy after each iteration to the trace (if given).
+  */
+void
+optimize(mrf::Graph::Ptr mrf, std::size_t mrf_id, Settings const & settings,
+    MRFEnergyTrace * trace) {
+
+    bool verbose = mrf->num_sites() > 10000;
+
+    util::WallTimer timer;
+
+    mrf::ENERGY_TYPE const zero = mrf::ENERGY_TYPE(0);
+    mrf::ENERGY_TYPE energy = mrf->compute_energy();
+    unsigned int iter = 0;
 
-    for (std::size_t i = 0; i < mrfs.size(); ++i) {
-        /* Set costs for undefined label */
-        std::vector<mrf::SparseDataCost> costs(mrfs[i]->num_sites());
-        for (std::size_t j = 0; j < costs.size(); j++) {
-            costs[j].site = j;
-            costs[j].cost = MRF_MAX_ENERGYTERM;
+    std::string const comp = util::string::get_filled(mrf_id, 4);
+    std::string status;
+    bool stop = false;
+
+    while (true) {
+        float const elapsed = timer.get_elapsed_sec();
+        #pragma omp critical
+        {
+            if (verbose) {
+                std::cout << "\t" << comp << "\t" << iter << "\t" << energy
+                    << "\t" << elapsed << std::endl;
+            }
+            if (trace != nullptr) {
+                trace->push_back({mrf_id, iter, energy, elapsed});
+            }
+        }
+
+        if (stop) break;
+
+        if (settings.mrf_max_iterations > 0 && iter >= settings.mrf_max_iterations) {
+            status = "Reached maximum number of iterations";
+            break;
         }
-        mrfs[i]->set_data_costs(0, costs);
+        if (settings.mrf_max_time > 0.0f && elapsed >= settings.mrf_max_time) {
+            status = "Reached maximum runtime";
+            break;
+        }
+
+        mrf::ENERGY_TYPE const last_energy = energy;
+        ++iter;
+        energy = mrf->optimize(1);
+        mrf::ENERGY_TYPE const diff = last_energy - energy;
+
+        stop = true;
+        if (diff == zero) {
+            status = "Converged";
+        } else if (diff < zero) {
+            status = "Increase of energy - stopping optimization";
+        } else if (diff <= settings.mrf_tolerance * std::abs(last_energy)) {
+            status = "Converged (relative energy decrease below tolerance)";
+        } else {
+            stop = false;
+        }
+    }
+
+    #pragma omp critical
+    if (verbose) {
+        std::cout << "\t" << comp << "\t" << status << std::endl;
     }
 }
 
-/** Remove all edges of nodes which corresponding face has not been seen in any texture view. */
+/** Stores the labels of the MRF sites in the graph nodes of the corresponding faces. */
 void
-isolate_unseen_faces(UniGraph * graph, DataCosts const & data_costs) {
-    int num_unseen_faces = 0;
-    for (std::uint32_t i = 0; i < data_costs.cols(); i++) {
-        DataCosts::Column const & data_costs_for_face = data_costs.col(i);
+extract_labels(mrf::Graph::Ptr mrf, std::vector<std::size_t> const & faces,
+    std::size_t num_labels, UniGraph * graph) {
+    for (std::size_t j = 0; j < faces.size(); ++j) {
+        int label = mrf->what_label(static_cast<int>(j));
+        assert(0 <= label && static_cast<std::size_t>(label) < num_labels);
+        graph->set_label(faces[j], static_cast<std::size_t>(label));
+    }
+}
 
-        if (data_costs_for_face.size() == 0) {
-            num_unseen_faces++;
+/**
+  * Sets the labels of the MRF sites to the given labels of the corresponding faces,
+  * faces with label 0 (undefined) keep the label with the lowest data cost.
+  */
+void
+set_initial_labels(mrf::Graph::Ptr mrf, std::vector<std::size_t> const & faces,
+    std::vector<std::size_t> const & labels) {
+    for (std::size_t j = 0; j < faces.size(); ++j) {
+        std::size_t const label = labels[faces[j]];
+        if (label == 0) continue;
+        mrf->set_label(static_cast<int>(j), static_cast<int>(label));
+    }
+}
+
+/**
+  * Clusters the faces of a component or part into superfaces by region growing. A face
+  * only joins a superface if it is seen in the best view of the superface's seed,
+  * i.e. all faces of a superface share at least one view.
+  * site_index(face) returns the index of the face within faces or OUTSIDE.
+  * Returns the superface of each face (indexed by site_index(face)).
+  */
+template <typename SiteIndex> std::vector<std::size_t>
+cluster_superfaces(std::vector<std::size_t> const & faces, SiteIndex const & site_index,
+    FaceGraph const & mgraph, DataCosts const & data_costs, std::size_t * num_superfaces) {
+
+    std::size_t const unassigned = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> superfaces(faces.size(), unassigned);
+    std::vector<std::size_t> queue;
+    *num_superfaces = 0;
+
+    for (std::size_t i = 0; i < faces.size(); ++i) {
+        if (superfaces[i] != unassigned) continue;
+
+        DataCosts::Column const & seed_costs = data_costs.col(faces[i]);
+        std::size_t const seed_label = lowest_cost_label(seed_costs);
+
+        std::size_t const superface = (*num_superfaces)++;
+        superfaces[i] = superface;
+        if (seed_label == 0) continue;
+        std::uint16_t const view = static_cast<std::uint16_t>(seed_label - 1);
+
+        queue.assign(1, i);
+        std::size_t size = 1;
+        for (std::size_t q = 0; q < queue.size() && size < SUPERFACE_SIZE; ++q) {
+            for (std::size_t adj_face : mgraph.get_adj_nodes(faces[queue[q]])) {
+                std::size_t const id = site_index(adj_face);
+                if (id == OUTSIDE || superfaces[id] != unassigned) continue;
+
+                DataCosts::Column const & adj_costs = data_costs.col(adj_face);
+                bool seen = false;
+                for (std::size_t j = 0; j < adj_costs.size() && !seen; ++j) {
+                    seen = adj_costs[j].first == view;
+                }
+                if (!seen) continue;
+
+                superfaces[id] = superface;
+                queue.push_back(id);
+                if (++size == SUPERFACE_SIZE) break;
+            }
+        }
+    }
+
+    return superfaces;
+}
+
+/**
+  * Initializes the labels of the MRF of a component or part (its first faces.size() sites)
+  * with the labeling of a coarse MRF over superfaces (see cluster_superfaces). Faces
+  * outside of faces (e.g. fixed faces of neighboring parts) are not considered.
+  * The data costs of a superface are the sums
+  * of the data costs of its faces for all views shared by them, adjacent superfaces are
+  * neighbors in the coarse MRF and the smoothness term of their edge is weighted by the
+  * length of their common boundary. Data costs and weights are divided by SUPERFACE_SIZE
+  * to fit the 16 bit data costs, i.e. the coarse energy of a labeling is the energy of
+  * the corresponding face labeling divided by SUPERFACE_SIZE. Solvers which only take
+  * integral weights optimize the coarse MRF with alpha expansion instead.
+  */
+template <typename SiteIndex> void
+initialize_from_superfaces(mrf::Graph::Ptr mrf, std::vector<std::size_t> const & faces,
+    std::size_t mrf_id, SiteIndex const & site_index, FaceGraph const & mgraph,
+    DataCosts const & data_costs, Settings const & settings) {
+
+    std::size_t num_superfaces;
+    std::vector<std::size_t> superfaces = cluster_superfaces(faces, site_index, mgraph,
+        data_costs, &num_superfaces);
+
+    /* Faces of each superface. */
+    std::vector<std::size_t> offsets(num_superfaces + 1, 0);
+    for (std::size_t superface : superfaces) offsets[superface + 1] += 1;
+    for (std::size_t i = 0; i < num_superfaces; ++i) offsets[i + 1] += offsets[i];
+    std::vector<std::size_t> members(faces.size());
+    std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < faces.size(); ++i) members[next[superfaces[i]]++] = i;
+
+    /* Adjacent superfaces and the length of their common boundary (number of shared face
+     * edges) - each pair of adjacent faces appears once from either side. */
+    std::vector<std::pair<std::size_t, std::size_t> > adjacencies;
+    for (std::size_t i = 0; i < faces.size(); ++i) {
+        for (std::size_t adj_face : mgraph.get_adj_nodes(faces[i])) {
+            std::size_t const id = site_index(adj_face);
+            if (id == OUTSIDE) continue;
+            std::size_t const superface1 = superfaces[i];
+            std::size_t const superface2 = superfaces[id];
+            if (superface1 != superface2) adjacencies.emplace_back(superface1, superface2);
+        }
+    }
+    std::sort(adjacencies.begin(), adjacencies.end());
+
+    std::vector<std::size_t> neighbor_offsets(num_superfaces + 1, 0);
+    std::vector<int> neighbors;
+    std::vector<mrf::ENERGY_TYPE> weights;
+    for (std::size_t j = 0; j < adjacencies.size();) {
+        std::size_t k = j;
+        while (k < adjacencies.size() && adjacencies[k] == adjacencies[j]) ++k;
+        neighbor_offsets[adjacencies[j].first + 1] += 1;
+        neighbors.push_back(static_cast<int>(adjacencies[j].second));
+        /* Scaled like the data costs. */
+        weights.push_back(mrf::ENERGY_TYPE(k - j) / SUPERFACE_SIZE);
+        j = k;
+    }
+    std::vector<std::pair<std::size_t, std::size_t> >().swap(adjacencies);
+    for (std::size_t i = 0; i < num_superfaces; ++i) neighbor_offsets[i + 1] += neighbor_offsets[i];
+
+    /* Label (view + 1, 0 is undefined) and data cost for each superface. */
+    std::vector<std::vector<std::pair<int, mrf::DATA_COST_TYPE> > > superface_costs(num_superfaces);
+    #pragma omp parallel
+    {
+        std::vector<DataCosts::Column::value_type > entries;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for (std::size_t superface = 0; superface < num_superfaces; ++superface) {
+            std::size_t const size = offsets[superface + 1] - offsets[superface];
+
+            entries.clear();
+            for (std::size_t j = offsets[superface]; j < offsets[superface + 1]; ++j) {
+                DataCosts::Column const & data_costs_for_face = data_costs.col(faces[members[j]]);
+                entries.insert(entries.end(), data_costs_for_face.begin(), data_costs_for_face.end());
+            }
+            std::sort(entries.begin(), entries.end());
+
+            for (std::size_t j = 0; j < entries.size();) {
+                std::size_t k = j;
+                std::uint32_t cost = 0;
+                for (; k < entries.size() && entries[k].first == entries[j].first; ++k) {
+                    cost += mrf_data_cost(entries[k].second);
+                }
+                if (k - j == size) {
+                    mrf::DATA_COST_TYPE const scaled_cost = mrf::saturating_cast(double(cost) / SUPERFACE_SIZE);
+                    superface_costs[superface].emplace_back(entries[j].first + 1, scaled_cost);
+                }
+                j = k;
+            }
+            mrf::DATA_COST_TYPE const undefined_cost =
+                mrf::saturating_cast(double(MRF_MAX_ENERGYTERM) * size / SUPERFACE_SIZE);
+            superface_costs[superface].emplace_back(0, undefined_cost);
+        }
+    }
 
-            std::vector<std::size_t> const & adj_nodes = graph->get_adj_nodes(i);
-            for (std::size_t j = 0; j < adj_nodes.size(); j++)
-                graph->remove_edge(i, adj_nodes[j]);
+    std::vector<std::size_t> cost_offsets(1, 0);
+    std::vector<int> labels;
+    std::vector<mrf::DATA_COST_TYPE> costs;
+    for (std::size_t superface = 0; superface < num_superfaces; ++superface) {
+        for (std::pair<int, mrf::DATA_COST_TYPE> const & entry : superface_costs[superface]) {
+            labels.push_back(entry.first);
+            costs.push_back(entry.second);
         }
+        cost_offsets.push_back(labels.size());
+        std::vector<std::pair<int, mrf::DATA_COST_TYPE> >().swap(superface_costs[superface]);
+    }
 
+    std::size_t const num_labels = data_costs.rows() + 1;
+    /* The weights are fractional - solvers with integral weights only (GCO)
+     * are replaced by alpha expansion. */
+    mrf::SOLVER_TYPE const coarse_solver = mrf::Graph::supports_fractional_weights(settings.solver_type)
+        ? settings.solver_type : mrf::EXPANSION;
+    mrf::Graph::Ptr coarse = mrf::Graph::create(num_superfaces, num_labels, coarse_solver);
+    coarse->set_smooth_cost(smooth_cost_function(settings));
+    coarse->set_graph(neighbor_offsets, neighbors, cost_offsets, labels, costs, weights);
+
+    optimize(coarse, mrf_id, settings, nullptr);
+
+    for (std::size_t i = 0; i < faces.size(); ++i) {
+        mrf->set_label(static_cast<int>(i), coarse->what_label(static_cast<int>(superfaces[i])));
     }
-    std::cout << "\t" << num_unseen_faces << " faces have not been seen by a view." << std::endl;
 }
 
+/** Settings for refining a multilevel initialization: at most REFINEMENT_ITERATIONS iterations. */
+Settings
+refinement_settings(Settings const & settings) {
+    Settings refinement_settings = settings;
+    if (settings.mrf_max_iterations == 0 || settings.mrf_max_iterations > REFINEMENT_ITERATIONS) {
+        refinement_settings.mrf_max_iterations = REFINEMENT_ITERATIONS;
+    }
+    return refinement_settings;
+}
+
+/**
+  * Builds and optimizes the MRF of a component and stores the resulting labels in
+  * the graph, the MRF is released afterwards. The MRF is initialized with the
+  * initial labeling if given. Otherwise, in multilevel mode, the MRF is initialized
+  * with the solution for superfaces and only refined for up to REFINEMENT_ITERATIONS
+  * iterations.
+  */
 void
-view_selection(DataCosts const & data_costs, UniGraph * graph, Settings const & settings) {
-    UniGraph mgraph(*graph);
-    isolate_unseen_faces(&mgraph, data_costs);
+optimize_component(std::vector<std::size_t> const & faces,
+    std::size_t comp_id, std::vector<FaceInfo> const & face_infos, FaceGraph const & mgraph,
+    DataCosts const & data_costs, Settings const & settings,
+    std::vector<std::size_t> const * initial_labeling, MRFEnergyTrace * trace,
+    UniGraph * graph) {
+
+    std::size_t const num_labels = data_costs.rows() + 1;
+    mrf::Graph::Ptr mrf = mrf::Graph::create(faces.size(), num_labels, settings.solver_type);
+    mrf->set_smooth_cost(smooth_cost_function(settings));
+    set_graph(mrf, faces, face_infos, mgraph, data_costs);
+    if (initial_labeling != nullptr) {
+        set_initial_labels(mrf, faces, *initial_labeling);
+        optimize(mrf, comp_id, settings, trace);
+    } else if (settings.multilevel_view_selection && faces.size() > MIN_MULTILEVEL_SITES) {
+        auto site_index = [&face_infos] (std::size_t face) -> std::size_t {
+            return face_infos[face].id;
+        };
+        initialize_from_superfaces(mrf, faces, comp_id, site_index, mgraph, data_costs, settings);
+        optimize(mrf, comp_id, refinement_settings(settings), trace);
+    } else {
+        optimize(mrf, comp_id, settings, trace);
+    }
+    extract_labels(mrf, faces, num_labels, graph);
+}
 
-    unsigned int num_components = 0;
+/**
+  * Optimizes the labels of the faces of a part (part_infos[face_infos[face].id].part == part
+  * and part_infos[face_infos[face].id].id is the index of the face within faces).
+  * All adjacent faces outside of the part keep their labels given by fixed_labels
+  * (fixed boundary conditions): they are added as sites with their fixed label as only
+  * label, such that the smoothness costs towards them are counted in both directions.
+  * If initial_labels is given, the optimization starts from these labels. Otherwise,
+  * in multilevel mode, the part is initialized and refined like a component
+  * (see optimize_component).
+  */
+void
+optimize_part(std::vector<std::size_t> const & faces, std::size_t part,
+    std::vector<FaceInfo> const & face_infos, std::vector<PartInfo> const & part_infos,
+    std::vector<std::size_t> const & fixed_labels, std::vector<std::size_t> const * initial_labels,
+    FaceGraph const & mgraph, DataCosts const & data_costs, Settings const & settings,
+    std::size_t mrf_id, MRFEnergyTrace * trace, UniGraph * graph) {
+
+    std::size_t const num_labels = data_costs.rows() + 1;
+
+    std::vector<std::size_t> neighbor_offsets(1, 0);
+    std::vector<int> neighbors;
+    std::vector<std::size_t> cost_offsets(1, 0);
+    std::vector<int> labels;
+    std::vector<mrf::DATA_COST_TYPE> costs;
+    /* Sites of the fixed faces (following the sites of the part) and their neighbors. */
+    std::map<std::size_t, int> fixed_sites;
+    std::vector<std::size_t> fixed_faces;
+    std::vector<std::vector<int> > fixed_neighbors;
+    for (std::size_t i = 0; i < faces.size(); ++i) {
+        std::size_t const face = faces[i];
+        int const site = static_cast<int>(i);
+
+        for (std::size_t adj_face : mgraph.get_adj_nodes(face)) {
+            PartInfo const & adj_info = part_infos[face_infos[adj_face].id];
+            if (adj_info.part == part) {
+                neighbors.push_back(static_cast<int>(adj_info.id));
+                continue;
+            }
 
-    std::vector<FaceInfo> face_infos(mgraph.num_nodes());
-    std::vector<std::vector<std::size_t> > components;
-    mgraph.get_subgraphs(0, &components);
-    for (std::size_t i = 0; i < components.size(); ++i) {
-        if (components.size() > 1000) num_components += 1;
-        for (std::size_t j = 0; j < components[i].size(); ++j) {
-            face_infos[components[i][j]] = {i, j};
+            int const fixed_site = static_cast<int>(faces.size() + fixed_faces.size());
+            auto inserted = fixed_sites.insert(std::make_pair(adj_face, fixed_site));
+            if (inserted.second) {
+                fixed_faces.push_back(adj_face);
+                fixed_neighbors.emplace_back();
+            }
+            neighbors.push_back(inserted.first->second);
+            fixed_neighbors[inserted.first->second - faces.size()].push_back(site);
+        }
+        neighbor_offsets.push_back(neighbors.size());
+
+        DataCosts::Column const & data_costs_for_face = data_costs.col(face);
+        for (std::size_t j = 0; j < data_costs_for_face.size(); ++j) {
+            labels.push_back(data_costs_for_face[j].first + 1);
+            costs.push_back(mrf_data_cost(data_costs_for_face[j].second));
         }
+        labels.push_back(0);
+        costs.push_back(MRF_MAX_ENERGYTERM);
+        cost_offsets.push_back(labels.size());
     }
 
-    #ifdef RESEARCH
-    mrf::SOLVER_TYPE solver_type = mrf::GCO;
-    #else
-    mrf::SOLVER_TYPE solver_type = mrf::LBP;
-    #endif
+    for (std::size_t i = 0; i < fixed_faces.size(); ++i) {
+        neighbors.insert(neighbors.end(), fixed_neighbors[i].begin(), fixed_neighbors[i].end());
+        neighbor_offsets.push_back(neighbors.size());
+        labels.push_back(static_cast<int>(fixed_labels[fixed_faces[i]]));
+        costs.push_back(0);
+        cost_offsets.push_back(labels.size());
+    }
 
-    /* Label 0 is undefined. */
-    const std::size_t num_labels = data_costs.rows() + 1;
-    std::vector<mrf::Graph::Ptr> mrfs(components.size());
-    for (std::size_t i = 0; i < components.size(); ++i) {
-        mrfs[i] = mrf::Graph::create(components[i].size(), num_labels, solver_type);
+    std::size_t const num_sites = faces.size() + fixed_faces.size();
+    mrf::Graph::Ptr mrf = mrf::Graph::create(num_sites, num_labels, settings.solver_type);
+    mrf->set_smooth_cost(smooth_cost_function(settings));
+    mrf->set_graph(neighbor_offsets, neighbors, cost_offsets, labels, costs);
+
+    if (initial_labels != nullptr) {
+        set_initial_labels(mrf, faces, *initial_labels);
+        optimize(mrf, mrf_id, settings, trace);
+    } else if (settings.multilevel_view_selection && faces.size() > MIN_MULTILEVEL_SITES) {
+        auto site_index = [&] (std::size_t face) -> std::size_t {
+            PartInfo const & info = part_infos[face_infos[face].id];
+            return info.part == part ? info.id : OUTSIDE;
+        };
+        initialize_from_superfaces(mrf, faces, mrf_id, site_index, mgraph, data_costs, settings);
+        optimize(mrf, mrf_id, refinement_settings(settings), trace);
+    } else {
+        optimize(mrf, mrf_id, settings, trace);
     }
+    extract_labels(mrf, faces, num_labels, graph);
+}
 
-    /* Set neighbors must be called prior to set_data_costs (LBP). */
-    set_neighbors(mgraph, face_infos, mrfs);
+/**
+  * Optimizes a component that is too large for a single MRF:
+  * The component is split into partitions with partition_mesh, which are optimized
+  * in parallel while the faces of neighboring partitions are fixed to their initial
+  * label (or the label with the lowest data cost). Without initial labeling, in
+  * multilevel mode, each partition is initialized from its superfaces (see
+  * optimize_part). Afterwards, a band along the
+  * partition borders is optimized again, starting from and with the partitions
+  * fixed to their results, to reconcile the borders.
+  * The MRFs are numbered starting with first_mrf_id, returns the number of MRFs.
+  */
+std::size_t
+optimize_partitioned(std::vector<std::size_t> const & component, std::size_t comp_id,
+    std::vector<FaceInfo> const & face_infos, FaceGraph const & mgraph,
+    DataCosts const & data_costs, Settings const & settings,
+    std::vector<std::size_t> const * initial_labeling,
+    std::size_t first_mrf_id, MRFEnergyTrace * trace, UniGraph * graph) {
+
+    std::size_t const num_faces = component.size();
+
+    UniGraph subgraph(num_faces);
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        for (std::size_t adj_face : mgraph.get_adj_nodes(component[i])) {
+            std::size_t const j = face_infos[adj_face].id;
+            if (i < j) subgraph.add_edge(i, j);
+        }
+    }
 
-    set_data_costs(face_infos, data_costs, mrfs);
+    std::size_t const min_num_partitions =
+        (num_faces + MAX_MRF_SITES - 1) / MAX_MRF_SITES;
+    partition_mesh(&subgraph, min_num_partitions);
 
-    bool multiple_components_simultaneously = false;
-    #ifdef RESEARCH
-    multiple_components_simultaneously = true;
-    #endif
-    #ifndef _OPENMP
-    multiple_components_simultaneously = false;
-    #endif
+    std::size_t num_partitions = 0;
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        num_partitions = std::max(num_partitions, subgraph.get_label(i) + 1);
+    }
+
+    std::vector<std::vector<std::size_t> > partitions(num_partitions);
+    for (std::size_t i = 0; i < num_faces; ++i) {
+        partitions[subgraph.get_label(i)].push_back(component[i]);
+    }
+
+    /* Largest partitions first - better load balance with dynamic scheduling. */
+    std::stable_sort(partitions.begin(), partitions.end(),
+        [] (std::vector<std::size_t> const & a, std::vector<std::size_t> const & b) -> bool {
+            return a.size() > b.size();
+        });
+
+    /* Partition of each face, indexed by face_infos[face].id. */
+    std::vector<PartInfo> part_infos(num_faces);
+    for (std::size_t i = 0; i < num_partitions; ++i) {
+        for (std::size_t j = 0; j < partitions[i].size(); ++j) {
+            part_infos[face_infos[partitions[i][j]].id] = {i, j};
+        }
+    }
 
-    if (multiple_components_simultaneously) {
-        if (num_components > 0) {
-            std::cout << "\tOptimizing " << num_components
-                << " components simultaneously." << std::endl;
+    /* Initial labels of the boundaries: initial labeling or lowest data cost. */
+    std::vector<std::size_t> labels(mgraph.num_nodes(), 0);
+    for (std::size_t face : component) {
+        if (initial_labeling != nullptr && initial_labeling->at(face) != 0) {
+            labels[face] = initial_labeling->at(face);
+            continue;
         }
-        std::cout << "\tComp\tIter\tEnergy\t\tRuntime" << std::endl;
+        labels[face] = lowest_cost_label(data_costs.col(face));
     }
-    #ifdef RESEARCH
+
+    std::cout << "\tOptimizing component " << comp_id << " (" << num_faces
+        << " faces) as " << num_partitions << " partitions simultaneously (MRFs "
+        << first_mrf_id << " - " << first_mrf_id + num_partitions - 1 << ")." << std::endl;
+
     #pragma omp parallel for schedule(dynamic)
-    #endif
-    for (std::size_t i = 0; i < components.size(); ++i) {
-        switch (settings.smoothness_term) {
-            case POTTS:
-                mrfs[i]->set_smooth_cost(*potts);
+    for (std::size_t i = 0; i < num_partitions; ++i) {
+        optimize_part(partitions[i], i, face_infos, part_infos, labels, initial_labeling,
+            mgraph, data_costs, settings, first_mrf_id + i, trace, graph);
+    }
+
+    /* Band along the partition borders. */
+    std::vector<bool> in_band(mgraph.num_nodes(), false);
+    std::vector<std::size_t> band;
+    for (std::size_t face : component) {
+        labels[face] = graph->get_label(face);
+        std::size_t const partition = part_infos[face_infos[face].id].part;
+        for (std::size_t adj_face : mgraph.get_adj_nodes(face)) {
+            if (part_infos[face_infos[adj_face].id].part == partition) continue;
+            in_band[face] = true;
+            band.push_back(face);
             break;
         }
+    }
+    for (std::size_t ring = 1, begin = 0; ring < BAND_WIDTH; ++ring) {
+        std::size_t const end = band.size();
+        for (std::size_t i = begin; i < end; ++i) {
+            for (std::size_t adj_face : mgraph.get_adj_nodes(band[i])) {
+                if (in_band[adj_face]) continue;
+                in_band[adj_face] = true;
+                band.push_back(adj_face);
+            }
+        }
+        begin = end;
+    }
 
-        bool verbose = mrfs[i]->num_sites() > 10000;
+    if (band.empty()) return num_partitions;
 
-        util::WallTimer timer;
+    part_infos.assign(num_faces, {OUTSIDE, 0});
+    for (std::size_t i = 0; i < band.size(); ++i) {
+        part_infos[face_infos[band[i]].id] = {0, i};
+    }
 
-        mrf::ENERGY_TYPE const zero = mrf::ENERGY_TYPE(0);
-        mrf::ENERGY_TYPE last_energy = zero;
-        mrf::ENERGY_TYPE energy = mrfs[i]->compute_energy();
-        mrf::ENERGY_TYPE diff = last_energy - energy;
-        unsigned int iter = 0;
+    std::cout << "\tReconciling " << band.size() << " faces along the partition borders." << std::endl;
+    optimize_part(band, 0, face_infos, part_infos, labels, &labels, mgraph, data_costs, settings,
+        first_mrf_id + num_partitions, trace, graph);
 
-        std::string const comp = util::string::get_filled(i, 4);
+    return num_partitions + 1;
+}
 
-        if (verbose && !multiple_components_simultaneously) {
-            std::cout << "\tComp\tIter\tEnergy\t\tRuntime" << std::endl;
+/**
+  * Fast view selection without MRF optimization: Each face is assigned the view
+  * with its lowest data cost, afterwards speckles are removed by a few sweeps in
+  * which each face adopts the label of the strict majority of its neighbors
+  * (if the face is seen in that view).
+  * If initial_labeling is given, its labels are used instead of the lowest data costs.
+  */
+void
+fast_view_selection(DataCosts const & data_costs, FaceGraph const & mgraph,
+    std::vector<std::size_t> const * initial_labeling, UniGraph * graph) {
+
+    std::size_t const num_faces = mgraph.num_nodes();
+    std::vector<std::size_t> labels(num_faces, 0);
+
+    #pragma omp parallel for
+    for (std::size_t face = 0; face < num_faces; ++face) {
+        DataCosts::Column const & data_costs_for_face = data_costs.col(face);
+        std::size_t const initial_label = initial_labeling != nullptr ? (*initial_labeling)[face] : 0;
+        auto has_initial_label = [initial_label] (DataCosts::Column::value_type const & entry) -> bool {
+            return entry.first + 1u == initial_label;
+        };
+        if (initial_label != 0 && std::any_of(data_costs_for_face.begin(),
+                data_costs_for_face.end(), has_initial_label)) {
+            labels[face] = initial_label;
+        } else {
+            labels[face] = lowest_cost_label(data_costs_for_face);
         }
-        while (diff != zero) {
-            #pragma omp critical
-            if (verbose) {
-                std::cout << "\t" << comp << "\t" << iter << "\t" << energy
-                    << "\t" << timer.get_elapsed_sec() << std::endl;
+    }
+
+    std::vector<std::size_t> new_labels(num_faces);
+    int sweep = 0;
+    std::size_t num_changed = 1;
+    while (sweep < MAJORITY_SWEEPS && num_changed > 0) {
+        num_changed = 0;
+        #pragma omp parallel for schedule(dynamic, 1024) reduction(+:num_changed)
+        for (std::size_t face = 0; face < num_faces; ++face) {
+            new_labels[face] = labels[face];
+            if (labels[face] == 0) continue;
+
+            FaceGraph::AdjNodes const adj_faces = mgraph.get_adj_nodes(face);
+            std::size_t majority_label = 0;
+            std::size_t majority_votes = 0;
+            for (std::size_t adj_face : adj_faces) {
+                std::size_t const label = labels[adj_face];
+                if (label == 0 || label == majority_label) continue;
+
+                std::size_t votes = 0;
+                for (std::size_t other_face : adj_faces) {
+                    if (labels[other_face] == label) votes += 1;
+                }
+                if (votes > majority_votes) {
+                    majority_label = label;
+                    majority_votes = votes;
+                }
+            }
+            if (2 * majority_votes <= adj_faces.size()) continue;
+            if (majority_label == labels[face]) continue;
+
+            DataCosts::Column const & data_costs_for_face = data_costs.col(face);
+            for (std::size_t j = 0; j < data_costs_for_face.size(); ++j) {
+                if (data_costs_for_face[j].first + 1u != majority_label) continue;
+                new_labels[face] = majority_label;
+                num_changed += 1;
+                break;
             }
-            last_energy = energy;
-            ++iter;
-            energy = mrfs[i]->optimize(1);
-            diff = last_energy - energy;
-            if (diff <= zero) break;
         }
+        labels.swap(new_labels);
+        sweep += 1;
 
-        #pragma omp critical
-        if (verbose) {
-            std::cout << "\t" << comp << "\t" << iter << "\t" << energy << std::endl;
-            if (diff == zero) {
-                std::cout << "\t" << comp << "\t" << "Converged" << std::endl;
+        std::cout << "\tSweep " << sweep << ": " << num_changed
+            << " faces relabeled" << std::endl;
+    }
+
+    for (std::size_t face = 0; face < num_faces; ++face) {
+        graph->set_label(face, labels[face]);
+    }
+}
+
+/**
+  * Relabels islands (connected faces with the same label) of less than min_size faces
+  * or with an area below min_area (if face_areas is given) to the label of an adjacent
+  * face, which would otherwise each become a texture patch. The label sharing the most
+  * edges with the island is chosen among those in which all faces of the island are seen.
+  * Islands are merged in ascending order of their size, each with the current labels,
+  * i.e. including the islands merged into it before.
+  */
+void
+relabel_small_islands(DataCosts const & data_costs, std::size_t min_size, float min_area,
+    std::vector<float> const * face_areas, UniGraph * graph) {
+    std::size_t const num_faces = graph->num_nodes();
+    std::size_t const unvisited = std::numeric_limits<std::size_t>::max();
+    bool const use_area = face_areas != nullptr && min_area > 0.0f;
+    if (min_size == 0 && !use_area) return;
+
+    std::vector<std::size_t> stamps(num_faces, unvisited);
+    std::vector<std::size_t> island;
+    float island_area = 0.0f;
+    std::vector<std::pair<std::size_t, std::size_t> > adj_labels;
+
+    auto is_small = [&] () -> bool {
+        return island.size() < min_size || (use_area && island_area < min_area);
+    };
+
+    /* Flood fills the island of seed with the current labels (marking its faces with
+     * stamp) and collects the labels across its border. With stop_if_large the fill
+     * stops as soon as the island turns out not to be small. */
+    auto fill_island = [&] (std::size_t seed, std::size_t stamp, bool stop_if_large) {
+        std::size_t const label = graph->get_label(seed);
+        island.assign(1, seed);
+        island_area = use_area ? (*face_areas)[seed] : 0.0f;
+        stamps[seed] = stamp;
+        adj_labels.clear();
+        for (std::size_t i = 0; i < island.size(); ++i) {
+            if (stop_if_large && !is_small()) return;
+            for (std::size_t adj_face : graph->get_adj_nodes(island[i])) {
+                std::size_t const adj_label = graph->get_label(adj_face);
+                if (adj_label != label) {
+                    if (adj_label != 0) adj_labels.emplace_back(adj_label, adj_face);
+                    continue;
+                }
+                if (stamps[adj_face] == stamp) continue;
+                stamps[adj_face] = stamp;
+                island.push_back(adj_face);
+                if (use_area) island_area += (*face_areas)[adj_face];
             }
-            if (diff < zero) {
-                std::cout << "\t" << comp << "\t"
-                    << "Increase of energy - stopping optimization" << std::endl;
+        }
+    };
+
+    /* Small islands of the initial labeling: size, area and seed. */
+    std::vector<std::tuple<std::size_t, float, std::size_t> > small_islands;
+    for (std::size_t seed = 0; seed < num_faces; ++seed) {
+        if (stamps[seed] != unvisited) continue;
+        fill_island(seed, seed, false);
+        if (graph->get_label(seed) == 0 || !is_small()) continue;
+        small_islands.emplace_back(island.size(), island_area, seed);
+    }
+    std::sort(small_islands.begin(), small_islands.end());
+
+    std::size_t num_relabeled = 0;
+    for (std::size_t i = 0; i < small_islands.size(); ++i) {
+        /* The island may have grown by the islands merged into it. */
+        fill_island(std::get<2>(small_islands[i]), num_faces + i, true);
+        if (!is_small()) continue;
+
+        /* Order the adjacent labels by the number of shared edges. */
+        std::sort(adj_labels.begin(), adj_labels.end());
+        std::vector<std::pair<std::size_t, std::size_t> > candidates;
+        for (std::size_t j = 0; j < adj_labels.size();) {
+            std::size_t k = j;
+            while (k < adj_labels.size() && adj_labels[k].first == adj_labels[j].first) ++k;
+            candidates.emplace_back(k - j, adj_labels[j].first);
+            j = k;
+        }
+        std::sort(candidates.rbegin(), candidates.rend());
+
+        for (std::pair<std::size_t, std::size_t> const & candidate : candidates) {
+            std::size_t const new_label = candidate.second;
+            bool seen = true;
+            for (std::size_t j = 0; j < island.size() && seen; ++j) {
+                DataCosts::Column const & data_costs_for_face = data_costs.col(island[j]);
+                seen = std::any_of(data_costs_for_face.begin(), data_costs_for_face.end(),
+                    [new_label] (DataCosts::Column::value_type const & entry) -> bool {
+                        return entry.first + 1u == new_label;
+                    });
             }
+            if (!seen) continue;
+
+            for (std::size_t face : island) graph->set_label(face, new_label);
+            num_relabeled += 1;
+            break;
         }
+    }
+
+    std::cout << "\tRelabeled " << num_relabeled << " of " << small_islands.size()
+        << " small islands." << std::endl;
+}
+
+/** Returns whether the solver parallelizes the optimization of a single MRF. */
+bool
+solver_is_parallel(mrf::SOLVER_TYPE solver_type) {
+    return solver_type == mrf::LBP || solver_type == mrf::RESIDUAL_LBP;
+}
+
+void
+view_selection(DataCosts const & all_data_costs, UniGraph * graph, Settings const & settings,
+    MRFEnergyTrace * trace, std::vector<std::size_t> const * initial_labeling,
+    std::vector<float> const * face_areas) {
+    FaceGraph const mgraph = isolate_unseen_faces(*graph, all_data_costs);
+
+    if (settings.fast_view_selection) {
+        fast_view_selection(all_data_costs, mgraph, initial_labeling, graph);
+        relabel_small_islands(all_data_costs, settings.min_island_size,
+            settings.min_island_area, face_areas, graph);
+        return;
+    }
+
+    DataCosts pruned_data_costs;
+    if (settings.mrf_max_labels > 0) {
+        prune_labels(all_data_costs, mgraph, settings.mrf_max_labels, &pruned_data_costs);
+    }
+    DataCosts const & data_costs =
+        settings.mrf_max_labels > 0 ? pruned_data_costs : all_data_costs;
 
-        /* Extract resulting labeling from MRF. */
+    unsigned int num_components = 0;
+
+    std::vector<FaceInfo> face_infos(mgraph.num_nodes());
+    std::vector<std::vector<std::size_t> > components;
+    mgraph.get_components(&components);
+    for (std::size_t i = 0; i < components.size(); ++i) {
+        if (components[i].size() > 1000) num_components += 1;
         for (std::size_t j = 0; j < components[i].size(); ++j) {
-            int label = mrfs[i]->what_label(static_cast<int>(j));
-            assert(0 <= label && static_cast<std::size_t>(label) < num_labels);
-            graph->set_label(components[i][j], static_cast<std::size_t>(label));
+            face_infos[components[i][j]] = {i, j};
+        }
+    }
+
+    /* The MRF of each component is built right before its optimization. */
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> partitioned;
+    for (std::size_t i = 0; i < components.size(); ++i) {
+        if (components[i].size() > MAX_MRF_SITES) {
+            partitioned.push_back(i);
+        } else {
+            order.push_back(i);
         }
     }
+
+    /* Largest components first, they dominate the runtime. */
+    std::stable_sort(order.begin(), order.end(),
+        [&components] (std::size_t a, std::size_t b) -> bool {
+            return components[a].size() > components[b].size();
+        });
+
+    /* Components large enough to benefit from the parallelism of the solver
+     * are optimized one after another. */
+    std::size_t const min_parallel_sites = 10000;
+    std::size_t num_sequential = 0;
+    if (solver_is_parallel(settings.solver_type)) {
+        while (num_sequential < order.size()
+            && components[order[num_sequential]].size() > min_parallel_sites) {
+            num_sequential += 1;
+        }
+    }
+
+    if (num_components > 0) {
+        std::cout << "\tOptimizing " << num_components
+            << " components simultaneously." << std::endl;
+    }
+    std::cout << "\tComp\tIter\tEnergy\t\tRuntime" << std::endl;
+
+    for (std::size_t i = 0; i < num_sequential; ++i) {
+        std::size_t const comp_id = order[i];
+        optimize_component(components[comp_id], comp_id, face_infos,
+            mgraph, data_costs, settings, initial_labeling, trace, graph);
+    }
+
+    /* Remaining components simultaneously - dynamic scheduling hands the next
+     * (smaller) component to whichever thread becomes idle. Nested parallel
+     * regions within the solvers are executed by a single thread. */
+    #pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = num_sequential; i < order.size(); ++i) {
+        std::size_t const comp_id = order[i];
+        optimize_component(components[comp_id], comp_id, face_infos,
+            mgraph, data_costs, settings, initial_labeling, trace, graph);
+    }
+
+    /* Components exceeding MAX_MRF_SITES faces. */
+    std::size_t next_mrf_id = components.size();
+    for (std::size_t comp_id : partitioned) {
+        next_mrf_id += optimize_partitioned(components[comp_id], comp_id, face_infos,
+            mgraph, data_costs, settings, initial_labeling, next_mrf_id, trace, graph);
+    }
+
+    relabel_small_islands(all_data_costs, settings.min_island_size,
+        settings.min_island_area, face_areas, graph);
+}
+
+void
+save_mrf_energies(std::string const & filename, MRFEnergyTrace const & trace) {
+    std::ofstream out(filename.c_str());
+    if (!out.good())
+        throw util::FileException(filename, std::strerror(errno));
+
+    out << "MRF, Iteration, Energy, Seconds" << std::endl;
+    for (MRFEnergy const & entry : trace) {
+        out << entry.mrf << ", " << entry.iteration << ", "
+            << entry.energy << ", " << entry.seconds << std::endl;
+    }
+    out.close();
 }
 
 TEX_NAMESPACE_END
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TESTS_MRFTEST_HEADER
+#define TESTS_MRFTEST_HEADER
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "mrf/graph.h"
+
+/**
+  * Small MRF instance which can be loaded into any solver and minimized by
+  * enumerating all labelings. The labels of site s and their data costs are
+  * stored in labels[s] and costs[s], edge i connects edges[i].first and
+  * edges[i].second with weight weights[i].
+  */
+struct Instance {
+    int num_sites;
+    int num_labels;
+    std::vector<std::vector<int> > labels;
+    std::vector<std::vector<mrf::DATA_COST_TYPE> > costs;
+    std::vector<std::pair<int, int> > edges;
+    std::vector<mrf::ENERGY_TYPE> weights;
+};
+
+/**
+  * Creates an instance with random data costs in [0, max_cost] for the labels
+  * 1 to num_labels - 1 (label 0 is not used). Each label is available for a
+  * site with the given probability, at least one label is always available.
+  */
+inline Instance
+random_instance(int num_sites, int num_labels, std::vector<std::pair<int, int> > const & edges,
+    int max_cost, double label_probability, bool fractional_weights, std::mt19937 * gen) {
+
+    std::uniform_int_distribution<int> cost_dist(0, max_cost);
+    std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+    std::uniform_int_distribution<int> label_dist(1, num_labels - 1);
+
+    Instance instance;
+    instance.num_sites = num_sites;
+    instance.num_labels = num_labels;
+    instance.labels.resize(num_sites);
+    instance.costs.resize(num_sites);
+    for (int site = 0; site < num_sites; ++site) {
+        int const forced_label = label_dist(*gen);
+        for (int label = 1; label < num_labels; ++label) {
+            if (label != forced_label && unit_dist(*gen) >= label_probability) continue;
+            instance.labels[site].push_back(label);
+            instance.costs[site].push_back(cost_dist(*gen));
+        }
+    }
+
+    instance.edges = edges;
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        instance.weights.push_back(fractional_weights
+            ? static_cast<mrf::ENERGY_TYPE>(0.25 + unit_dist(*gen)) : 1.0f);
+    }
+    return instance;
+}
+
+/** Edges of a width x height 4-neighborhood grid. */
+inline std::vector<std::pair<int, int> >
+grid_edges(int width, int height) {
+    std::vector<std::pair<int, int> > edges;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int const site = y * width + x;
+            if (x + 1 < width) edges.emplace_back(site, site + 1);
+            if (y + 1 < height) edges.emplace_back(site, site + width);
+        }
+    }
+    return edges;
+}
+
+/** Edges of a random tree, each site is connected to one of the preceding sites. */
+inline std::vector<std::pair<int, int> >
+random_tree_edges(int num_sites, std::mt19937 * gen) {
+    std::vector<std::pair<int, int> > edges;
+    for (int site = 1; site < num_sites; ++site) {
+        std::uniform_int_distribution<int> parent_dist(0, site - 1);
+        edges.emplace_back(parent_dist(*gen), site);
+    }
+    return edges;
+}
+
+/** Edges of a random graph in which each pair of sites is connected with the given probability. */
+inline std::vector<std::pair<int, int> >
+random_graph_edges(int num_sites, double edge_probability, std::mt19937 * gen) {
+    std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+    std::vector<std::pair<int, int> > edges;
+    for (int site1 = 0; site1 < num_sites; ++site1) {
+        for (int site2 = site1 + 1; site2 < num_sites; ++site2) {
+            if (unit_dist(*gen) < edge_probability) edges.emplace_back(site1, site2);
+        }
+    }
+    return edges;
+}
+
+/** Creates a solver of the given type and loads the instance into it. */
+inline mrf::Graph::Ptr
+create_graph(Instance const & instance, mrf::SOLVER_TYPE solver_type,
+    mrf::SmoothCostFunction smooth_cost) {
+
+    mrf::Graph::Ptr graph = mrf::Graph::create(instance.num_sites,
+        instance.num_labels, solver_type);
+
+    for (std::size_t i = 0; i < instance.edges.size(); ++i) {
+        graph->set_neighbors(instance.edges[i].first, instance.edges[i].second,
+            instance.weights[i]);
+    }
+
+    std::vector<std::vector<mrf::SparseDataCost> > costs(instance.num_labels);
+    for (int site = 0; site < instance.num_sites; ++site) {
+        for (std::size_t j = 0; j < instance.labels[site].size(); ++j) {
+            costs[instance.labels[site][j]].push_back({site, instance.costs[site][j]});
+        }
+    }
+    for (int label = 0; label < instance.num_labels; ++label) {
+        if (!costs[label].empty()) graph->set_data_costs(label, costs[label]);
+    }
+
+    graph->set_smooth_cost(smooth_cost);
+    return graph;
+}
+
+/**
+  * Energy of the labeling given by label indices (into instance.labels) -
+  * like the solvers, the smoothness term of each edge is counted in both directions.
+  */
+inline double
+energy(Instance const & instance, mrf::SmoothCostFunction smooth_cost,
+    std::vector<std::size_t> const & label_indices) {
+
+    double sum = 0.0;
+    for (int site = 0; site < instance.num_sites; ++site)
+        sum += instance.costs[site][label_indices[site]];
+    for (std::size_t i = 0; i < instance.edges.size(); ++i) {
+        int const site1 = instance.edges[i].first;
+        int const site2 = instance.edges[i].second;
+        int const label1 = instance.labels[site1][label_indices[site1]];
+        int const label2 = instance.labels[site2][label_indices[site2]];
+        sum += instance.weights[i] * (smooth_cost(site1, site2, label1, label2)
+            + smooth_cost(site2, site1, label2, label1));
+    }
+    return sum;
+}
+
+/** Energy of the current labeling of the solver. */
+inline double
+energy(Instance const & instance, mrf::SmoothCostFunction smooth_cost, mrf::Graph::Ptr graph) {
+    std::vector<std::size_t> label_indices(instance.num_sites);
+    for (int site = 0; site < instance.num_sites; ++site) {
+        std::vector<int> const & labels = instance.labels[site];
+        int const label = graph->what_label(site);
+        label_indices[site] = std::find(labels.begin(), labels.end(), label) - labels.begin();
+        if (label_indices[site] == labels.size()) return std::numeric_limits<double>::max();
+    }
+    return energy(instance, smooth_cost, label_indices);
+}
+
+/** Returns the minimal energy by enumerating all labelings. */
+inline double
+brute_force_minimum(Instance const & instance, mrf::SmoothCostFunction smooth_cost) {
+    std::vector<std::size_t> label_indices(instance.num_sites, 0);
+    double min_energy = std::numeric_limits<double>::max();
+    while (true) {
+        min_energy = std::min(min_energy, energy(instance, smooth_cost, label_indices));
+
+        /* Next labeling (counting with mixed radix). */
+        int site = 0;
+        for (; site < instance.num_sites; ++site) {
+            label_indices[site] += 1;
+            if (label_indices[site] < instance.labels[site].size()) break;
+            label_indices[site] = 0;
+        }
+        if (site == instance.num_sites) break;
+    }
+    return min_energy;
+}
+
+#endif /* TESTS_MRFTEST_HEADER */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <random>
+
+#include "mrf/graph.h"
+
+#include "test.h"
+#include "mrf_test.h"
+
+namespace {
+
+mrf::ENERGY_TYPE
+scaled_potts(int, int, int l1, int l2) {
+    return l1 == l2 ? 0 : 5000;
+}
+
+/** Non-metric (violates the triangle inequality) and asymmetric. */
+mrf::ENERGY_TYPE
+squared_difference(int s1, int s2, int l1, int l2) {
+    return (l1 - l2) * (l1 - l2) * (s1 < s2 ? 300 : 200);
+}
+
+/**
+  * Checks that every iteration of alpha-expansion keeps or decreases the
+  * energy and that the returned energy matches the labeling.
+  */
+void
+test_monotone(mrf::SmoothCostFunction smooth_cost, int max_cost, std::mt19937 * gen) {
+    for (int i = 0; i < 20; ++i) {
+        int const num_sites = 40;
+        Instance instance = random_instance(num_sites, 8,
+            random_graph_edges(num_sites, 0.1, gen), max_cost, 0.6, true, gen);
+        mrf::Graph::Ptr graph = create_graph(instance, mrf::EXPANSION, smooth_cost);
+
+        double previous_energy = graph->compute_energy();
+        CHECK_NEAR(previous_energy, energy(instance, smooth_cost, graph));
+        for (int j = 0; j < 10; ++j) {
+            double const current_energy = graph->optimize(1);
+            CHECK(current_energy <= previous_energy);
+            CHECK_NEAR(current_energy, energy(instance, smooth_cost, graph));
+            previous_energy = current_energy;
+        }
+    }
+}
+
+/**
+  * With two labels and all sites starting with the first label, the expansion
+  * of the second label considers all labelings - the result has to be optimal.
+  */
+void
+test_two_label_grid(mrf::SmoothCostFunction smooth_cost, int max_cost, std::mt19937 * gen) {
+    for (int i = 0; i < 20; ++i) {
+        int const width = 4;
+        int const height = 4;
+        Instance instance = random_instance(width * height, 3,
+            grid_edges(width, height), max_cost, 1.0, i % 2 == 1, gen);
+        mrf::Graph::Ptr graph = create_graph(instance, mrf::EXPANSION, smooth_cost);
+        for (int site = 0; site < instance.num_sites; ++site)
+            graph->set_label(site, 1);
+
+        double const optimized_energy = graph->optimize(5);
+        CHECK_NEAR(optimized_energy, energy(instance, smooth_cost, graph));
+        CHECK_NEAR(optimized_energy, brute_force_minimum(instance, smooth_cost));
+    }
+}
+
+}
+
+int main(void) {
+    std::mt19937 gen(0);
+
+    test_monotone(mrf::potts, MRF_MAX_ENERGYTERM, &gen);
+    test_monotone(scaled_potts, 10000, &gen);
+    test_monotone(squared_difference, 10000, &gen);
+
+    test_two_label_grid(mrf::potts, MRF_MAX_ENERGYTERM, &gen);
+    test_two_label_grid(scaled_potts, 10000, &gen);
+
+    return TEST_RESULT;
+}
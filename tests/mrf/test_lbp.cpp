@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <random>
+
+#include "mrf/graph.h"
+
+#include "test.h"
+#include "mrf_test.h"
+
+namespace {
+
+mrf::ENERGY_TYPE
+scaled_potts(int, int, int l1, int l2) {
+    return l1 == l2 ? 0 : 1000;
+}
+
+/**
+  * Checks that residual belief propagation converges to the same labeling as
+  * belief propagation with the flooding schedule on small grids. The smoothness
+  * term is kept weak compared to the data costs (scaled by weight_scale) - with
+  * strong coupling flooding oscillates on grids instead of converging.
+  */
+void
+test_residual_schedule(mrf::SmoothCostFunction smooth_cost, float weight_scale,
+    std::mt19937 * gen) {
+    for (int i = 0; i < 20; ++i) {
+        int const width = 5;
+        int const height = 5;
+        Instance instance = random_instance(width * height, 5,
+            grid_edges(width, height), 10000, 0.8, i % 2 == 1, gen);
+        for (mrf::ENERGY_TYPE & weight : instance.weights)
+            weight *= weight_scale;
+        mrf::Graph::Ptr flooding = create_graph(instance, mrf::LBP, smooth_cost);
+        mrf::Graph::Ptr residual = create_graph(instance, mrf::RESIDUAL_LBP, smooth_cost);
+
+        double const flooding_energy = flooding->optimize(100);
+        double const residual_energy = residual->optimize(100);
+        CHECK_NEAR(flooding_energy, energy(instance, smooth_cost, flooding));
+        CHECK_NEAR(residual_energy, energy(instance, smooth_cost, residual));
+        CHECK_NEAR(flooding_energy, residual_energy);
+
+        for (int site = 0; site < instance.num_sites; ++site)
+            CHECK(flooding->what_label(site) == residual->what_label(site));
+    }
+}
+
+}
+
+int main(void) {
+    std::mt19937 gen(0);
+
+    test_residual_schedule(mrf::potts, 0.02f, &gen);
+    test_residual_schedule(scaled_potts, 1.0f, &gen);
+
+    return TEST_RESULT;
+}
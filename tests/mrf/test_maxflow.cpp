@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "mrf/maxflow.h"
+
+#include "test.h"
+
+namespace {
+
+struct Edge {
+    int node1;
+    int node2;
+    double cap;
+    double rev_cap;
+};
+
+/** Capacity of the cut given by the sink segment. */
+double
+cut_capacity(std::vector<double> const & source_caps, std::vector<double> const & sink_caps,
+    std::vector<Edge> const & edges, std::vector<bool> const & sink_segment) {
+
+    double capacity = 0.0;
+    for (std::size_t node = 0; node < sink_segment.size(); ++node)
+        capacity += sink_segment[node] ? source_caps[node] : sink_caps[node];
+    for (Edge const & edge : edges) {
+        if (!sink_segment[edge.node1] && sink_segment[edge.node2]) capacity += edge.cap;
+        if (sink_segment[edge.node1] && !sink_segment[edge.node2]) capacity += edge.rev_cap;
+    }
+    return capacity;
+}
+
+/**
+  * Compares the maximum flow and the capacity of the computed cut with the
+  * minimum cut found by enumerating all cuts of a random graph.
+  */
+void
+test_random_graph(int num_nodes, double edge_probability, std::mt19937 * gen) {
+    std::uniform_int_distribution<int> cap_dist(0, 20);
+    std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+
+    std::vector<double> source_caps(num_nodes);
+    std::vector<double> sink_caps(num_nodes);
+    std::vector<Edge> edges;
+    for (int node = 0; node < num_nodes; ++node) {
+        source_caps[node] = unit_dist(*gen) < 0.5 ? cap_dist(*gen) : 0;
+        sink_caps[node] = unit_dist(*gen) < 0.5 ? cap_dist(*gen) : 0;
+    }
+    for (int node1 = 0; node1 < num_nodes; ++node1) {
+        for (int node2 = 0; node2 < num_nodes; ++node2) {
+            if (node1 == node2 || unit_dist(*gen) >= edge_probability) continue;
+            edges.push_back({node1, node2, double(cap_dist(*gen)), double(cap_dist(*gen))});
+        }
+    }
+
+    mrf::MaxFlow maxflow;
+    maxflow.reset(num_nodes);
+    for (int node = 0; node < num_nodes; ++node)
+        maxflow.add_tweights(node, source_caps[node], sink_caps[node]);
+    for (Edge const & edge : edges)
+        maxflow.add_edge(edge.node1, edge.node2, edge.cap, edge.rev_cap);
+    double const flow = maxflow.maxflow();
+
+    std::vector<bool> sink_segment(num_nodes);
+    for (int node = 0; node < num_nodes; ++node)
+        sink_segment[node] = maxflow.in_sink_segment(node);
+
+    double min_cut = std::numeric_limits<double>::max();
+    for (unsigned int cut = 0; cut < (1u << num_nodes); ++cut) {
+        std::vector<bool> segment(num_nodes);
+        for (int node = 0; node < num_nodes; ++node)
+            segment[node] = (cut >> node) & 1;
+        min_cut = std::min(min_cut, cut_capacity(source_caps, sink_caps, edges, segment));
+    }
+
+    CHECK_NEAR(flow, min_cut);
+    CHECK_NEAR(cut_capacity(source_caps, sink_caps, edges, sink_segment), min_cut);
+}
+
+/** Checks that add_term2 represents all four values of a regular pairwise term. */
+void
+test_pairwise_terms(std::mt19937 * gen) {
+    std::uniform_int_distribution<int> cost_dist(0, 20);
+
+    for (int i = 0; i < 100; ++i) {
+        double const b = cost_dist(*gen);
+        double const c = cost_dist(*gen);
+        double const a = std::min(double(cost_dist(*gen)), b + c);
+        double const d = std::min(double(cost_dist(*gen)), b + c - a);
+        double const e[2][2] = {{a, b}, {c, d}};
+
+        /* Force both variables to each combination of values with large unary terms. */
+        for (int x1 = 0; x1 < 2; ++x1) {
+            for (int x2 = 0; x2 < 2; ++x2) {
+                mrf::MaxFlow maxflow;
+                maxflow.reset(2);
+                maxflow.add_term2(0, 1, a, b, c, d);
+                maxflow.add_term1(0, x1 == 0 ? 0 : 1000, x1 == 1 ? 0 : 1000);
+                maxflow.add_term1(1, x2 == 0 ? 0 : 1000, x2 == 1 ? 0 : 1000);
+                double const flow = maxflow.maxflow();
+                CHECK(maxflow.in_sink_segment(0) == (x1 == 1));
+                CHECK(maxflow.in_sink_segment(1) == (x2 == 1));
+
+                /* The flow equals the energy up to the constant A. */
+                CHECK_NEAR(flow + a, e[x1][x2]);
+            }
+        }
+    }
+}
+
+}
+
+int main(void) {
+    std::mt19937 gen(0);
+
+    for (int i = 0; i < 200; ++i)
+        test_random_graph(1 + i % 10, 0.3, &gen);
+    for (int i = 0; i < 50; ++i)
+        test_random_graph(10, 0.8, &gen);
+
+    test_pairwise_terms(&gen);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <memory>
+#include <random>
+
+#include "mrf/trws_graph.h"
+
+#include "test.h"
+#include "mrf_test.h"
+
+namespace {
+
+/** Non-metric (violates the triangle inequality) and asymmetric. */
+mrf::ENERGY_TYPE
+squared_difference(int s1, int s2, int l1, int l2) {
+    return (l1 - l2) * (l1 - l2) * (s1 < s2 ? 300 : 200);
+}
+
+/** Checks that the lower bound never exceeds the energy of the labeling or the optimum. */
+void
+test_lower_bound(mrf::SmoothCostFunction smooth_cost, int max_cost, std::mt19937 * gen) {
+    for (int i = 0; i < 20; ++i) {
+        int const num_sites = 10;
+        Instance instance = random_instance(num_sites, 4,
+            random_graph_edges(num_sites, 0.4, gen), max_cost, 0.8, i % 2 == 1, gen);
+        mrf::Graph::Ptr graph = create_graph(instance, mrf::TRWS, smooth_cost);
+        std::shared_ptr<mrf::TRWSGraph> trws = std::dynamic_pointer_cast<mrf::TRWSGraph>(graph);
+        CHECK(trws != nullptr);
+        if (trws == nullptr) return;
+
+        double const min_energy = brute_force_minimum(instance, smooth_cost);
+        for (int j = 0; j < 10; ++j) {
+            double const current_energy = graph->optimize(1);
+            double const bound = trws->lower_bound();
+            CHECK_NEAR(current_energy, energy(instance, smooth_cost, graph));
+            CHECK(current_energy >= min_energy - 1e-4 * min_energy);
+            CHECK(bound <= min_energy + 1e-4 * min_energy);
+        }
+    }
+}
+
+/** Checks that TRW-S finds the optimum of tree-structured instances with a tight bound. */
+void
+test_tree(mrf::SmoothCostFunction smooth_cost, int max_cost, std::mt19937 * gen) {
+    for (int i = 0; i < 20; ++i) {
+        int const num_sites = 9;
+        Instance instance = random_instance(num_sites, 4,
+            random_tree_edges(num_sites, gen), max_cost, 1.0, i % 2 == 1, gen);
+        mrf::Graph::Ptr graph = create_graph(instance, mrf::TRWS, smooth_cost);
+        std::shared_ptr<mrf::TRWSGraph> trws = std::dynamic_pointer_cast<mrf::TRWSGraph>(graph);
+
+        double const min_energy = brute_force_minimum(instance, smooth_cost);
+        double const optimized_energy = graph->optimize(10);
+        CHECK_NEAR(optimized_energy, energy(instance, smooth_cost, graph));
+        CHECK_NEAR(optimized_energy, min_energy);
+        CHECK_NEAR(trws->lower_bound(), min_energy);
+    }
+}
+
+}
+
+int main(void) {
+    std::mt19937 gen(0);
+
+    test_lower_bound(mrf::potts, MRF_MAX_ENERGYTERM, &gen);
+    test_lower_bound(squared_difference, 10000, &gen);
+
+    test_tree(mrf::potts, MRF_MAX_ENERGYTERM, &gen);
+    test_tree(squared_difference, 10000, &gen);
+
+    return TEST_RESULT;
+}
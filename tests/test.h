@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#ifndef TESTS_TEST_HEADER
+#define TESTS_TEST_HEADER
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+/**
+  * Minimal checks for the test executables (independent of NDEBUG):
+  * failed checks are reported and turn the exit code of TEST_RESULT into a failure.
+  */
+static int test_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " \
+                << #cond << std::endl; \
+            test_failures += 1; \
+        } \
+    } while (0)
+
+/** Checks a == b up to a tolerance relative to their magnitude. */
+#define CHECK_NEAR(a, b) \
+    do { \
+        double const va = (a); \
+        double const vb = (b); \
+        if (std::abs(va - vb) > 1e-4 * std::max(1.0, std::max(std::abs(va), std::abs(vb)))) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " \
+                << #a << " (" << va << ") == " << #b << " (" << vb << ")" << std::endl; \
+            test_failures += 1; \
+        } \
+    } while (0)
+
+#define TEST_RESULT (test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
+
+#endif /* TESTS_TEST_HEADER */
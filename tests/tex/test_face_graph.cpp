@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2015, Nils Moehrle
+ * TU Darmstadt - Graphics, Capture and Massively Parallel Computing
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD 3-Clause license. See the LICENSE.txt file for details.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <mve/mesh.h>
+#include <mve/mesh_info.h>
+
+#include "tex/face_graph.h"
+#include "tex/uni_graph.h"
+
+#include "test.h"
+
+namespace {
+
+/**
+  * Small mesh with a non-manifold edge (0, 1) shared by the faces 0, 1 and 2,
+  * a face (5) touching face 0 only in a vertex and an isolated face (6).
+  */
+mve::TriangleMesh::Ptr
+create_mesh(void) {
+    mve::TriangleMesh::Ptr mesh = mve::TriangleMesh::create();
+    mve::TriangleMesh::VertexList & vertices = mesh->get_vertices();
+    mve::TriangleMesh::FaceList & faces = mesh->get_faces();
+
+    for (int i = 0; i < 11; ++i)
+        vertices.push_back(math::Vec3f(i % 4, i / 4, i % 3));
+
+    unsigned int const face_vertices[] = {
+        0, 1, 2,
+        1, 0, 3,
+        0, 1, 4,
+        2, 1, 5,
+        5, 1, 3,
+        6, 7, 2,
+        8, 9, 10
+    };
+    faces.assign(face_vertices, face_vertices + sizeof(face_vertices) / sizeof(unsigned int));
+    return mesh;
+}
+
+/** Builds the adjacency via the faces of each edge given by mve::MeshInfo. */
+void
+build_mesh_info_graph(mve::TriangleMesh::ConstPtr mesh, UniGraph * graph) {
+    mve::MeshInfo mesh_info(mesh);
+    mve::TriangleMesh::FaceList const & faces = mesh->get_faces();
+    for (std::size_t i = 0; i < faces.size(); i += 3) {
+        std::vector<std::size_t> adj_faces;
+        mesh_info.get_faces_for_edge(faces[i], faces[i + 1], &adj_faces);
+        mesh_info.get_faces_for_edge(faces[i + 1], faces[i + 2], &adj_faces);
+        mesh_info.get_faces_for_edge(faces[i + 2], faces[i], &adj_faces);
+
+        std::size_t const face = i / 3;
+        for (std::size_t adj_face : adj_faces) {
+            if (face != adj_face) graph->add_edge(face, adj_face);
+        }
+    }
+}
+
+template <typename AdjNodes> std::vector<std::size_t>
+sorted(AdjNodes const & adj_nodes) {
+    std::vector<std::size_t> nodes(adj_nodes.begin(), adj_nodes.end());
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+std::vector<std::vector<std::size_t> >
+sorted_components(std::vector<std::vector<std::size_t> > components) {
+    for (std::vector<std::size_t> & component : components)
+        std::sort(component.begin(), component.end());
+    std::sort(components.begin(), components.end());
+    return components;
+}
+
+void
+test_mesh_adjacency(void) {
+    mve::TriangleMesh::Ptr mesh = create_mesh();
+    std::size_t const num_faces = mesh->get_faces().size() / 3;
+
+    UniGraph uni_graph(num_faces);
+    build_mesh_info_graph(mesh, &uni_graph);
+    tex::FaceGraph face_graph(mesh);
+
+    CHECK(face_graph.num_nodes() == num_faces);
+    CHECK(face_graph.num_edges() == uni_graph.num_edges());
+    for (std::size_t face = 0; face < num_faces; ++face) {
+        tex::FaceGraph::AdjNodes const adj_nodes = face_graph.get_adj_nodes(face);
+        CHECK(std::is_sorted(adj_nodes.begin(), adj_nodes.end()));
+        CHECK(sorted(adj_nodes) == sorted(uni_graph.get_adj_nodes(face)));
+    }
+
+    /* All three faces of the non-manifold edge are adjacent to each other. */
+    CHECK(uni_graph.has_edge(0, 1) && uni_graph.has_edge(0, 2) && uni_graph.has_edge(1, 2));
+    /* Faces sharing only a vertex are not. */
+    CHECK(!uni_graph.has_edge(0, 5));
+    CHECK(face_graph.get_adj_nodes(6).size() == 0);
+
+    std::vector<std::vector<std::size_t> > uni_components;
+    uni_graph.get_subgraphs(0, &uni_components);
+    std::vector<std::vector<std::size_t> > components;
+    face_graph.get_components(&components);
+    CHECK(sorted_components(components) == sorted_components(uni_components));
+}
+
+void
+test_isolation_copy(void) {
+    mve::TriangleMesh::Ptr mesh = create_mesh();
+    std::size_t const num_faces = mesh->get_faces().size() / 3;
+
+    UniGraph uni_graph(num_faces);
+    build_mesh_info_graph(mesh, &uni_graph);
+
+    /* Isolate a face of the non-manifold edge and one of its neighbors. */
+    std::vector<bool> isolated(num_faces, false);
+    isolated[0] = true;
+    isolated[3] = true;
+    tex::FaceGraph face_graph(uni_graph, isolated);
+
+    CHECK(face_graph.num_nodes() == num_faces);
+    for (std::size_t face = 0; face < num_faces; ++face) {
+        std::vector<std::size_t> expected;
+        if (!isolated[face]) {
+            for (std::size_t adj_face : uni_graph.get_adj_nodes(face)) {
+                if (!isolated[adj_face]) expected.push_back(adj_face);
+            }
+        }
+
+        /* The order of the neighbors is kept. */
+        tex::FaceGraph::AdjNodes const adj_nodes = face_graph.get_adj_nodes(face);
+        CHECK(std::vector<std::size_t>(adj_nodes.begin(), adj_nodes.end()) == expected);
+    }
+
+    UniGraph remaining_graph(num_faces);
+    for (std::size_t face = 0; face < num_faces; ++face) {
+        for (std::size_t adj_face : uni_graph.get_adj_nodes(face)) {
+            if (!isolated[face] && !isolated[adj_face]) remaining_graph.add_edge(face, adj_face);
+        }
+    }
+    CHECK(face_graph.num_edges() == remaining_graph.num_edges());
+
+    std::vector<std::vector<std::size_t> > uni_components;
+    remaining_graph.get_subgraphs(0, &uni_components);
+    std::vector<std::vector<std::size_t> > components;
+    face_graph.get_components(&components);
+    CHECK(sorted_components(components) == sorted_components(uni_components));
+}
+
+}
+
+int main(void) {
+    test_mesh_adjacency();
+    test_isolation_copy();
+
+    return TEST_RESULT;
+}